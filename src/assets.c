@@ -0,0 +1,308 @@
+#include "assets.h"
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#	define PLATFORM_WINDOWS
+#elif defined(__APPLE__)
+#	define PLATFORM_APPLE
+#elif defined(__linux__) || defined(__gnu_linux__) || defined(linux)
+#	define PLATFORM_LINUX
+#elif defined(__unix__) || defined(unix)
+#	define PLATFORM_UNIX
+#else
+#	define PLATFORM_UNKNOWN
+#endif
+
+#ifdef PLATFORM_LINUX
+# 	define D_POSIX_C_SOURCE 200809L
+#	include <unistd.h>
+#endif
+
+#ifdef PLATFORM_WINDOWS
+#	include <windows.h>
+
+#	ifndef MAX_PATH
+#		define PATH_MAX 1024
+#	else
+#		define PATH_MAX MAX_PATH
+#	endif
+#else
+#	ifndef PATH_MAX
+#		define PATH_MAX 1024
+#	endif
+#endif
+
+static char *get_exec_folder_path(void) {
+	char *buf = (char*)malloc(PATH_MAX);
+	if (buf == NULL)
+		UNREACHABLE("malloc() fail");
+
+#if defined(PLATFORM_LINUX)
+	ssize_t len = readlink("/proc/self/exe", buf, PATH_MAX);
+	if (len != -1)
+		buf[len] = '\0';
+	else
+		strcpy(buf, argv[0]);
+#elif defined(PLATFORM_APPLE)
+	uint32_t len = PATH_MAX;
+	if (_NSGetExecutablePath(buf, &len) != 0)
+		strcpy(buf, argv[0]);
+#elif defined(PLATFORM_WINDOWS)
+	GetModuleFileName(NULL, buf, PATH_MAX);
+#else
+	strcpy(buf, argv[0]);
+#endif
+
+#if defined(PLATFORM_LINUX)
+	ssize_t i = len - 1;
+#elif defined(PLATFORM_APPLE)
+	uint32_t i = len - 1;
+#elif defined(PLATFORM_WINDOWS)
+	size_t i = len - 1;
+#endif
+
+	for (; i > 0; -- i) {
+		if (buf[i] == '/' || buf[i] == '\\') {
+			buf[i] = '\0';
+			break;
+		}
+	}
+
+	return buf;
+}
+
+#define ASSETS_FOLDER "cnake_assets"
+
+#define ATLAS_PATH ASSETS_FOLDER"/atlas.png"
+
+static SDL_Rect texture_rects[TEXTURES_COUNT] = {
+	[TEXTURE_EYES]      = ATLAS_RECT_EYES,
+	[TEXTURE_EYES_DEAD] = ATLAS_RECT_EYES_DEAD,
+	[TEXTURE_TONGUE]    = ATLAS_RECT_TONGUE,
+	[TEXTURE_GRASS1]    = ATLAS_RECT_GRASS1,
+	[TEXTURE_GRASS2]    = ATLAS_RECT_GRASS2,
+	[TEXTURE_CHEESE]    = ATLAS_RECT_CHEESE,
+	[TEXTURE_TUTORIAL]  = ATLAS_RECT_TUTORIAL,
+	[TEXTURE_PAUSED]    = ATLAS_RECT_PAUSED,
+	[TEXTURE_YOU_LOST]  = ATLAS_RECT_YOU_LOST,
+	[TEXTURE_SPACEBAR]  = ATLAS_RECT_SPACEBAR,
+};
+
+static char *sound_paths[SOUNDS_COUNT] = {
+	[SOUND_EAT]          = ASSETS_FOLDER"/sfx/eat.wav",
+	[SOUND_HIT]          = ASSETS_FOLDER"/sfx/hit.wav",
+	[SOUND_DEATH]        = ASSETS_FOLDER"/sfx/death.wav",
+	[SOUND_CHEESEBURGER] = ASSETS_FOLDER"/sfx/cheeseburger.wav",
+};
+
+static char *prefix_path(const char *path, const char *prefix) {
+	size_t size = strlen(prefix) + strlen(path) + 2;
+	char  *buf  = (char*)malloc(size);
+	memset(buf, 0, size);
+
+	strcat(buf, prefix);
+	strcat(buf, "/");
+	strcat(buf, path);
+
+	return buf;
+}
+
+/* Needs TTF_Init first, and can run on another thread than the one that uses the rest.
+ * Leaves it up to the caller what to do without a font, so it only logs when that fails. */
+bool assets_load_font(struct assets *a) {
+	Uint64 start = trace_begin();
+	char  *path = prefix_path(ASSETS_FOLDER"/fonts/deja_vu_sans.tff", a->folder);
+
+	a->font = TTF_OpenFont(path, SCORE_FONT_SIZE * 2);
+	if (a->font == NULL)
+		SDL_Log("Could not load font from '%s': %s", path, SDL_GetError());
+	else
+		SDL_Log("Loaded font from '%s'", path);
+
+	free(path);
+	trace_end("assets_load_font", start);
+	return a->font != NULL;
+}
+
+void assets_init(struct assets *a, SDL_Renderer *ren, bool keep_pixels) {
+	memset(a, 0, sizeof(*a));
+
+	a->ren         = ren;
+	a->folder      = get_exec_folder_path();
+	a->keep_pixels = keep_pixels;
+}
+
+static void assets_unload_atlas(struct assets *a) {
+	struct texture *atlas = &a->atlas;
+
+	SDL_DestroyTexture(atlas->sdl);
+	SDL_DestroyTexture(atlas->shadow);
+
+	if (atlas->pixels != NULL) {
+		SDL_FreeSurface(atlas->pixels);
+		SDL_FreeSurface(atlas->shadow_pixels);
+	}
+
+	memset(atlas, 0, sizeof(*atlas));
+	memset(a->texture, 0, sizeof(a->texture));
+}
+
+static void assets_unload_sound(struct assets *a, int key) {
+	a->sounds_size -= a->sound[key]->alen;
+
+	Mix_FreeChunk(a->sound[key]);
+	a->sound[key] = NULL;
+}
+
+void assets_free(struct assets *a) {
+	if (a->atlas.sdl != NULL)
+		assets_unload_atlas(a);
+
+	for (size_t i = 0; i < SOUNDS_COUNT; ++ i) {
+		if (a->sound[i] != NULL)
+			assets_unload_sound(a, i);
+	}
+
+	TTF_CloseFont(a->font);
+	free(a->folder);
+}
+
+static bool assets_sound_playing(Mix_Chunk *chunk) {
+	int channels = Mix_AllocateChannels(-1);
+	for (int i = 0; i < channels; ++ i) {
+		if (Mix_Playing(i) && Mix_GetChunk(i) == chunk)
+			return true;
+	}
+
+	return false;
+}
+
+static void assets_evict_sounds(struct assets *a, int keep) {
+	while (a->sounds_size > SOUNDS_BUDGET) {
+		int lru = -1;
+		for (int i = 0; i < SOUNDS_COUNT; ++ i) {
+			if (a->sound[i] == NULL || i == keep || assets_sound_playing(a->sound[i]))
+				continue;
+
+			if (lru == -1 || a->sound_used[i] < a->sound_used[lru])
+				lru = i;
+		}
+
+		if (lru == -1)
+			return;
+
+		assets_unload_sound(a, lru);
+		SDL_Log("Evicted sound '%s'", sound_paths[lru]);
+	}
+}
+
+/* Every texture is a sub-rect of the one atlas, so they all share its textures and pixels */
+static void assets_load_atlas(struct assets *a) {
+	Uint64 start = trace_begin();
+	char  *path = prefix_path(ATLAS_PATH, a->folder);
+
+	SDL_Surface *s = IMG_Load(path);
+	if (s == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	struct texture *atlas = &a->atlas;
+	atlas->sdl = SDL_CreateTextureFromSurface(a->ren, s);
+	if (atlas->sdl == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+	SDL_QueryTexture(atlas->sdl, NULL, NULL, &atlas->w, &atlas->h);
+
+	atlas->shadow = SDL_CreateShadowTextureFromSurface(a->ren, s, SHADOW_ALPHA);
+	if (atlas->shadow == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	if (a->keep_pixels) {
+		atlas->pixels        = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+		atlas->shadow_pixels = SDL_CreateShadowSurface(s, SHADOW_ALPHA);
+		if (atlas->pixels == NULL || atlas->shadow_pixels == NULL) {
+			SDL_Log("%s", SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	atlas->src = (SDL_Rect){.x = 0, .y = 0, .w = atlas->w, .h = atlas->h};
+	for (int i = 0; i < TEXTURES_COUNT; ++ i) {
+		a->texture[i]     = *atlas;
+		a->texture[i].src = texture_rects[i];
+		a->texture[i].w   = texture_rects[i].w;
+		a->texture[i].h   = texture_rects[i].h;
+	}
+
+	SDL_FreeSurface(s);
+	SDL_Log("Loaded texture atlas from '%s'", path);
+	free(path);
+
+	trace_end("assets_load_texture", start);
+}
+
+static void assets_load_sound(struct assets *a, int key) {
+	Uint64 start = trace_begin();
+	char  *path = prefix_path(sound_paths[key], a->folder);
+
+	a->sound[key] = Mix_LoadWAV(path);
+	if (a->sound[key] == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Log("Loaded sound from '%s'", path);
+	free(path);
+
+	a->sounds_size += a->sound[key]->alen;
+
+	trace_end("assets_load_sound", start);
+}
+
+struct texture *assets_texture(struct assets *a, int key) {
+	assert(key >= 0 && key < TEXTURES_COUNT);
+
+	if (a->atlas.sdl == NULL)
+		assets_load_atlas(a);
+
+	return &a->texture[key];
+}
+
+Mix_Chunk *assets_sound(struct assets *a, int key) {
+	assert(key >= 0 && key < SOUNDS_COUNT);
+
+	a->sound_used[key] = ++ a->sounds_clock;
+	if (a->sound[key] == NULL) {
+		assets_load_sound(a, key);
+		assets_evict_sounds(a, key);
+	}
+
+	return a->sound[key];
+}
+
+/* Maps the atlas, or its shadow, back to its pixels */
+SDL_Surface *assets_texture_pixels(struct assets *a, SDL_Texture *texture) {
+	if (a->atlas.sdl == NULL)
+		return NULL;
+	else if (a->atlas.sdl == texture)
+		return a->atlas.pixels;
+	else if (a->atlas.shadow == texture)
+		return a->atlas.shadow_pixels;
+	else
+		return NULL;
+}
+
+void assets_prefetch(struct assets *a, uint32_t textures, uint32_t sounds) {
+	for (int i = 0; i < TEXTURES_COUNT; ++ i) {
+		if (textures & ASSET_BIT(i))
+			assets_texture(a, i);
+	}
+
+	for (int i = 0; i < SOUNDS_COUNT; ++ i) {
+		if (sounds & ASSET_BIT(i))
+			assets_sound(a, i);
+	}
+}
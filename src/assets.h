@@ -0,0 +1,86 @@
+#ifndef ASSETS_H_HEADER_GUARD
+#define ASSETS_H_HEADER_GUARD
+
+#include <stdlib.h>  /* exit, EXIT_FAILURE, malloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <string.h>  /* memset, strcpy, strcat, strlen */
+#include <stdint.h>  /* uint32_t */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_mixer.h>
+
+#include "common.h"
+#include "config.h"
+#include "trace.h"
+
+/* Generated by the makefile, from the images packed into the atlas */
+#include "atlas_rects.h" /* ATLAS_RECT_* */
+
+enum {
+	TEXTURE_EYES = 0,
+	TEXTURE_EYES_DEAD,
+	TEXTURE_TONGUE,
+	TEXTURE_GRASS1,
+	TEXTURE_GRASS2,
+	TEXTURE_CHEESE,
+	TEXTURE_TUTORIAL,
+	TEXTURE_PAUSED,
+	TEXTURE_YOU_LOST,
+	TEXTURE_SPACEBAR,
+
+	TEXTURES_COUNT,
+};
+
+enum {
+	SOUND_EAT = 0,
+	SOUND_HIT,
+	SOUND_DEATH,
+	SOUND_CHEESEBURGER,
+
+	SOUNDS_COUNT,
+};
+
+#define ASSET_BIT(KEY) ((uint32_t)1 << (KEY))
+
+/* The pixels are only kept around for the software rasteriser, in SDL_PIXELFORMAT_ARGB8888.
+ * src is the part of sdl (and shadow) the texture covers, to be passed along when drawing it. */
+struct texture {
+	SDL_Texture *sdl, *shadow;
+	SDL_Surface *pixels, *shadow_pixels;
+	SDL_Rect     src;
+	int w, h;
+};
+
+/* All textures are packed into one atlas at build time, which is loaded on first use and kept
+ * until the end. Sound chunks are loaded on first use and kept in a least recently used cache,
+ * once it grows past its budget, the chunks that were not used for the longest time are freed
+ * again. The font is only loaded once assets_load_font is called. */
+struct assets {
+	char         *folder;
+	SDL_Renderer *ren;
+	bool          keep_pixels;
+
+	struct texture atlas;
+	struct texture texture[TEXTURES_COUNT];
+
+	Mix_Chunk *sound[SOUNDS_COUNT];
+	size_t     sound_used[SOUNDS_COUNT];
+	size_t     sounds_size, sounds_clock;
+
+	TTF_Font *font;
+};
+
+void assets_init(struct assets *a, SDL_Renderer *ren, bool keep_pixels);
+void assets_free(struct assets *a);
+bool assets_load_font(struct assets *a);
+
+void assets_prefetch(struct assets *a, uint32_t textures, uint32_t sounds);
+
+struct texture *assets_texture(struct assets *a, int key);
+Mix_Chunk      *assets_sound(struct assets *a, int key);
+
+SDL_Surface *assets_texture_pixels(struct assets *a, SDL_Texture *texture);
+
+#endif
@@ -0,0 +1,179 @@
+#include "bot.h"
+
+static int bot_run(void *data) {
+	struct bot *b = (struct bot*)data;
+
+	for (;;) {
+		SDL_SemWait(b->request);
+		if (SDL_AtomicGet(&b->quit))
+			break;
+
+		Uint64 start  = SDL_GetPerformanceCounter();
+		int    answer = b->api->think(b->state, &b->view);
+		Uint64 end    = SDL_GetPerformanceCounter();
+
+		b->answer    = answer;
+		b->answer_us = (end - start) * 1000000 / SDL_GetPerformanceFrequency();
+		SDL_SemPost(b->done);
+	}
+
+	return 0;
+}
+
+void bot_load(struct bot *b, const char *path) {
+	memset(b, 0, sizeof(*b));
+	b->path = path;
+
+	b->lib = SDL_LoadObject(path);
+	if (b->lib == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	void *symbol = SDL_LoadFunction(b->lib, CNAKE_BOT_ENTRY);
+	if (symbol == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	/* ISO C has no cast from an object pointer to a function pointer */
+	cnake_bot_entry_fn entry;
+	memcpy(&entry, &symbol, sizeof(entry));
+
+	b->api = entry();
+	if (b->api == NULL || b->api->api_version != CNAKE_BOT_API_VERSION) {
+		SDL_Log("Bot '%s' was built against another version of the bot API", path);
+		exit(EXIT_FAILURE);
+	}
+
+	b->state = b->api->create != NULL? b->api->create(COLS, ROWS) : NULL;
+
+	b->view.cols   = COLS;
+	b->view.rows   = ROWS;
+	b->view.body   = b->body;
+	b->view.cheese = b->cheese;
+
+	b->request = SDL_CreateSemaphore(0);
+	b->done    = SDL_CreateSemaphore(0);
+	if (b->request == NULL || b->done == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	b->thread = SDL_CreateThread(bot_run, "bot", b);
+	if (b->thread == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Log("Loaded bot '%s' from '%s'", b->api->name, path);
+}
+
+/* A bot that is stuck for good would keep the game from ever quitting, so it gets a last chance
+ * to finish and is otherwise left running */
+void bot_unload(struct bot *b) {
+	if (b->busy && SDL_SemWaitTimeout(b->done, BOT_UNLOAD_TIMEOUT_MS) != 0) {
+		SDL_Log("Bot '%s' is still thinking, leaving it behind", b->api->name);
+		SDL_DetachThread(b->thread);
+		return;
+	}
+
+	SDL_AtomicSet(&b->quit, true);
+	SDL_SemPost(b->request);
+	SDL_WaitThread(b->thread, NULL);
+
+	if (b->api->destroy != NULL)
+		b->api->destroy(b->state);
+
+	SDL_DestroySemaphore(b->request);
+	SDL_DestroySemaphore(b->done);
+	SDL_UnloadObject(b->lib);
+}
+
+static void bot_fill_view(struct bot *b, struct snake *s, struct cheese_pool *pool, size_t tick,
+                          size_t score) {
+	struct cnake_bot_view *v = &b->view;
+
+	v->tick     = tick;
+	v->score    = score;
+	v->dir      = s->dir;
+	v->next_dir = snake_next_dir(s);
+
+	SDL_Point cells[MAX_SNAKE_LEN];
+	snake_cells(s, cells);
+
+	v->len = s->len;
+	for (size_t i = 0; i < s->len; ++ i) {
+		b->body[i].x = cells[i].x;
+		b->body[i].y = cells[i].y;
+	}
+
+	v->cheese_count = pool->count;
+	for (size_t i = 0; i < pool->count; ++ i) {
+		b->cheese[i].x = pool->get[i].at.x;
+		b->cheese[i].y = pool->get[i].at.y;
+	}
+}
+
+static void bot_record(struct bot *b) {
+	struct bot_stats *stats = &b->stats;
+
+	stats->us[stats->count ++ % BOT_LATENCY_WINDOW] = b->answer_us;
+	if (b->answer_us > stats->max_us)
+		stats->max_us = b->answer_us;
+}
+
+/* Asks the bot where to go on this tick, false if it did not answer in time */
+bool bot_think(struct bot *b, struct snake *s, struct cheese_pool *pool, size_t tick,
+               size_t score, Uint32 timeout_ms, enum dir *dir) {
+	/* Whatever it was late with is of no use anymore */
+	if (b->busy) {
+		if (SDL_SemTryWait(b->done) != 0) {
+			++ b->stats.skipped;
+			return false;
+		}
+
+		b->busy = false;
+		bot_record(b);
+	}
+
+	bot_fill_view(b, s, pool, tick, score);
+
+	++ b->stats.calls;
+	SDL_SemPost(b->request);
+	if (SDL_SemWaitTimeout(b->done, timeout_ms) != 0) {
+		++ b->stats.late;
+		b->busy = true;
+		return false;
+	}
+
+	bot_record(b);
+	if (b->answer < CNAKE_BOT_UP || b->answer > CNAKE_BOT_RIGHT)
+		return false;
+
+	*dir = (enum dir)b->answer;
+	return true;
+}
+
+void bot_game_over(struct bot *b, size_t score) {
+	++ b->stats.games;
+	b->stats.score += score;
+}
+
+void bot_report(struct bot *b) {
+	struct bot_stats *stats = &b->stats;
+
+	size_t   count = stats->count < BOT_LATENCY_WINDOW? stats->count : BOT_LATENCY_WINDOW;
+	uint32_t sorted[BOT_LATENCY_WINDOW];
+	memcpy(sorted, stats->us, count * sizeof(*sorted));
+	qsort(sorted, count, sizeof(*sorted), compare_u32);
+
+	SDL_Log("Bot '%s': %zu games, %.1f average score", b->api->name, stats->games,
+	        stats->games > 0? (double)stats->score / stats->games : 0);
+	SDL_Log("Bot '%s': %zu calls, %zu late, %zu skipped while busy", b->api->name, stats->calls,
+	        stats->late, stats->skipped);
+
+	if (count > 0)
+		SDL_Log("Bot '%s': %u us median, %u us 99th percentile, %u us worst", b->api->name,
+		        sorted[count / 2], sorted[count * 99 / 100], stats->max_us);
+}
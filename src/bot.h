@@ -0,0 +1,59 @@
+#ifndef BOT_H_HEADER_GUARD
+#define BOT_H_HEADER_GUARD
+
+#include <stdlib.h>  /* exit, EXIT_FAILURE, qsort */
+#include <stdbool.h> /* bool, true, false */
+#include <string.h>  /* memset, memcpy */
+#include <stdint.h>  /* uint32_t */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "bot_api.h"
+#include "snake.h"
+#include "cheese.h"
+#include "config.h"
+
+/* Think times of the last BOT_LATENCY_WINDOW calls, measured on the bot thread around the call */
+struct bot_stats {
+	size_t   calls, late, skipped;
+	size_t   games, score;
+	uint32_t us[BOT_LATENCY_WINDOW];
+	size_t   count;
+	uint32_t max_us;
+};
+
+/* A bot loaded from a shared object. It thinks on a thread of its own, and the game only waits
+ * as long as it is given for it to answer. A bot that is late keeps its thread busy, and is
+ * skipped until it is done with the step it was late on. */
+struct bot {
+	const char             *path;
+	void                   *lib;
+	const struct cnake_bot *api;
+	void                   *state;
+
+	SDL_Thread  *thread;
+	SDL_sem     *request, *done;
+	SDL_atomic_t quit;
+	bool         busy;
+
+	/* Only ever written to while the bot is not thinking */
+	struct cnake_bot_view  view;
+	struct cnake_bot_point body[MAX_SNAKE_LEN];
+	struct cnake_bot_point cheese[CHEESE_CAPACITY];
+
+	int      answer;
+	uint32_t answer_us;
+
+	struct bot_stats stats;
+};
+
+void bot_load(struct bot *b, const char *path);
+void bot_unload(struct bot *b);
+
+bool bot_think(struct bot *b, struct snake *s, struct cheese_pool *pool, size_t tick,
+               size_t score, Uint32 timeout_ms, enum dir *dir);
+void bot_game_over(struct bot *b, size_t score);
+void bot_report(struct bot *b);
+
+#endif
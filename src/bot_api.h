@@ -0,0 +1,56 @@
+#ifndef BOT_API_H_HEADER_GUARD
+#define BOT_API_H_HEADER_GUARD
+
+#include <stdint.h> /* int32_t, uint32_t, uint64_t */
+
+/* The interface between the game and the bots it loads as shared objects, so it must not depend on
+ * SDL or anything else of the game. A bot exports CNAKE_BOT_ENTRY, a cnake_bot_entry_fn that hands
+ * out its functions. Anything that changes the layout of what is in here bumps the version. */
+
+#define CNAKE_BOT_API_VERSION 1
+#define CNAKE_BOT_ENTRY       "cnake_bot_entry"
+
+enum cnake_bot_dir {
+	CNAKE_BOT_UP = 0,
+	CNAKE_BOT_LEFT,
+	CNAKE_BOT_DOWN,
+	CNAKE_BOT_RIGHT,
+};
+
+struct cnake_bot_point {
+	int32_t x, y;
+};
+
+/* The board as it is on the tick the bot is asked about. It belongs to the game and stays as is
+ * until the bot returns, so a bot has to copy anything it wants to keep. */
+struct cnake_bot_view {
+	uint32_t cols, rows;
+	uint64_t tick;
+	uint32_t score;
+
+	/* The direction the snake is going in, and the one it will be going in once every turn it
+	 * was already told to take is taken */
+	uint32_t dir, next_dir;
+
+	/* The head comes first */
+	const struct cnake_bot_point *body;
+	uint32_t                      len;
+
+	const struct cnake_bot_point *cheese;
+	uint32_t                      cheese_count;
+};
+
+/* think returns a cnake_bot_dir, anything else keeps the snake going where it was going. It runs
+ * on a thread of its own, but never on more than one at a time. */
+struct cnake_bot {
+	uint32_t    api_version;
+	const char *name;
+
+	void *(*create)(uint32_t cols, uint32_t rows);
+	int   (*think)(void *bot, const struct cnake_bot_view *view);
+	void  (*destroy)(void *bot);
+};
+
+typedef const struct cnake_bot *(*cnake_bot_entry_fn)(void);
+
+#endif
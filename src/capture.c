@@ -0,0 +1,251 @@
+#include "capture.h"
+
+static bool capture_pop(struct capture *c, size_t *index, int *buffer) {
+	SDL_LockMutex(c->lock);
+	while (c->queue_count == 0 && !c->closing)
+		SDL_CondWait(c->queued, c->lock);
+
+	/* Only stop once everything that was queued before closing is written */
+	bool popped = c->queue_count > 0;
+	if (popped) {
+		*index  = c->queue[c->queue_start].index;
+		*buffer = c->queue[c->queue_start].buffer;
+
+		c->queue_start = (c->queue_start + 1) % CAPTURE_BUFFERS;
+		-- c->queue_count;
+	}
+	SDL_UnlockMutex(c->lock);
+
+	return popped;
+}
+
+static void capture_release(struct capture *c, int buffer) {
+	SDL_LockMutex(c->lock);
+	c->free_buffers[c->free_count ++] = buffer;
+	SDL_CondSignal(c->freed);
+	SDL_UnlockMutex(c->lock);
+}
+
+static void capture_write_png(struct capture *c, size_t index, uint32_t *pixels) {
+	size_t size = strlen(c->path) + 32;
+	char  *path = (char*)malloc(size);
+	if (path == NULL)
+		UNREACHABLE("malloc() fail");
+
+	snprintf(path, size, "%s/frame_%06zu.png", c->path, index);
+
+	SDL_Surface *s = SDL_CreateRGBSurfaceWithFormatFrom(pixels, c->w, c->h, 32, c->w * 4,
+	                                                    SDL_PIXELFORMAT_ARGB8888);
+	if (s == NULL || IMG_SavePNG(s, path) != 0)
+		SDL_Log("%s", SDL_GetError());
+
+	SDL_FreeSurface(s);
+	free(path);
+}
+
+/* BT.601 limited range, with the chroma averaged over each 2x2 block */
+static void capture_write_y4m(struct capture *c, uint32_t *pixels) {
+	int cw = (c->w + 1) / 2;
+	int ch = (c->h + 1) / 2;
+
+	uint8_t *y = c->yuv;
+	uint8_t *u = y + c->w * c->h;
+	uint8_t *v = u + cw * ch;
+
+	for (int i = 0; i < c->w * c->h; ++ i) {
+		int r = (pixels[i] >> 16) & 0xff;
+		int g = (pixels[i] >> 8)  & 0xff;
+		int b =  pixels[i]        & 0xff;
+
+		y[i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+	}
+
+	for (int cy = 0; cy < ch; ++ cy) {
+		for (int cx = 0; cx < cw; ++ cx) {
+			int r = 0, g = 0, b = 0, n = 0;
+
+			for (int py = cy * 2; py < cy * 2 + 2 && py < c->h; ++ py) {
+				for (int px = cx * 2; px < cx * 2 + 2 && px < c->w; ++ px) {
+					uint32_t p = pixels[py * c->w + px];
+
+					r += (p >> 16) & 0xff;
+					g += (p >> 8)  & 0xff;
+					b +=  p        & 0xff;
+					++ n;
+				}
+			}
+
+			r /= n;
+			g /= n;
+			b /= n;
+
+			u[cy * cw + cx] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+			v[cy * cw + cx] = ((112 * r - 94 * g - 18  * b + 128) >> 8) + 128;
+		}
+	}
+
+	fputs("FRAME\n", c->file);
+	fwrite(c->yuv, 1, c->w * c->h + cw * ch * 2, c->file);
+}
+
+static int capture_work(void *data) {
+	struct capture *c = (struct capture*)data;
+
+	size_t index;
+	int    buffer;
+	while (capture_pop(c, &index, &buffer)) {
+		switch (c->format) {
+		case CAPTURE_PNG: capture_write_png(c, index, c->buffers[buffer]); break;
+		case CAPTURE_Y4M: capture_write_y4m(c, c->buffers[buffer]);        break;
+
+		default: UNREACHABLE("Unknown capture format");
+		}
+
+		capture_release(c, buffer);
+	}
+
+	return 0;
+}
+
+static bool has_suffix(const char *str, const char *suffix) {
+	size_t len = strlen(str), suffix_len = strlen(suffix);
+	return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+void capture_init(struct capture *c, SDL_Renderer *ren, int w, int h, const char *path) {
+	memset(c, 0, sizeof(*c));
+
+	c->ren    = ren;
+	c->w      = w;
+	c->h      = h;
+	c->path   = path;
+	c->format = has_suffix(path, ".y4m")? CAPTURE_Y4M : CAPTURE_PNG;
+
+	for (int i = 0; i < 2; ++ i) {
+		c->targets[i] = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
+		                                  SDL_TEXTUREACCESS_TARGET, w, h);
+		if (c->targets[i] == NULL) {
+			SDL_Log("%s", SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (int i = 0; i < CAPTURE_BUFFERS; ++ i) {
+		c->buffers[i] = (uint32_t*)malloc(w * h * sizeof(*c->buffers[i]));
+		if (c->buffers[i] == NULL)
+			UNREACHABLE("malloc() fail");
+
+		c->free_buffers[c->free_count ++] = i;
+	}
+
+	c->lock   = SDL_CreateMutex();
+	c->queued = SDL_CreateCond();
+	c->freed  = SDL_CreateCond();
+	if (c->lock == NULL || c->queued == NULL || c->freed == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	if (c->format == CAPTURE_Y4M) {
+		c->file = fopen(path, "wb");
+		if (c->file == NULL) {
+			SDL_Log("Could not open '%s' for the capture", path);
+			exit(EXIT_FAILURE);
+		}
+
+		fprintf(c->file, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C420jpeg\n", w, h, TICK_RATE);
+
+		c->yuv = (uint8_t*)malloc(w * h + ((w + 1) / 2) * ((h + 1) / 2) * 2);
+		if (c->yuv == NULL)
+			UNREACHABLE("malloc() fail");
+
+		c->workers_count = 1;
+	} else {
+		c->workers_count = SDL_GetCPUCount() - 1;
+		if (c->workers_count < 1)
+			c->workers_count = 1;
+		else if (c->workers_count > CAPTURE_MAX_WORKERS)
+			c->workers_count = CAPTURE_MAX_WORKERS;
+	}
+
+	for (int i = 0; i < c->workers_count; ++ i) {
+		c->workers[i] = SDL_CreateThread(capture_work, "capture", c);
+		if (c->workers[i] == NULL) {
+			SDL_Log("%s", SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	SDL_Log("Capturing %s to '%s' with %i worker(s)", c->format == CAPTURE_Y4M? "a Y4M stream" :
+	        "a PNG sequence", path, c->workers_count);
+}
+
+static void capture_read_back(struct capture *c, SDL_Texture *target) {
+	SDL_LockMutex(c->lock);
+	while (c->free_count == 0)
+		SDL_CondWait(c->freed, c->lock);
+
+	int buffer = c->free_buffers[-- c->free_count];
+	SDL_UnlockMutex(c->lock);
+
+	SDL_SetRenderTarget(c->ren, target);
+	if (SDL_RenderReadPixels(c->ren, NULL, SDL_PIXELFORMAT_ARGB8888, c->buffers[buffer],
+	                         c->w * sizeof(*c->buffers[buffer])) != 0)
+		SDL_Log("%s", SDL_GetError());
+
+	SDL_LockMutex(c->lock);
+	size_t end = (c->queue_start + c->queue_count) % CAPTURE_BUFFERS;
+	c->queue[end].index  = c->frames ++;
+	c->queue[end].buffer = buffer;
+	++ c->queue_count;
+
+	SDL_CondSignal(c->queued);
+	SDL_UnlockMutex(c->lock);
+}
+
+void capture_free(struct capture *c) {
+	if (c->pending)
+		capture_read_back(c, c->targets[c->current ^ 1]);
+
+	SDL_SetRenderTarget(c->ren, NULL);
+
+	SDL_LockMutex(c->lock);
+	c->closing = true;
+	SDL_CondBroadcast(c->queued);
+	SDL_UnlockMutex(c->lock);
+
+	for (int i = 0; i < c->workers_count; ++ i)
+		SDL_WaitThread(c->workers[i], NULL);
+
+	SDL_Log("Captured %zu frames", c->frames);
+
+	if (c->file != NULL)
+		fclose(c->file);
+
+	free(c->yuv);
+	for (int i = 0; i < CAPTURE_BUFFERS; ++ i)
+		free(c->buffers[i]);
+
+	for (int i = 0; i < 2; ++ i)
+		SDL_DestroyTexture(c->targets[i]);
+
+	SDL_DestroyCond(c->freed);
+	SDL_DestroyCond(c->queued);
+	SDL_DestroyMutex(c->lock);
+}
+
+SDL_Texture *capture_target(struct capture *c) {
+	return c->targets[c->current];
+}
+
+/* Called once the current frame is drawn, leaves the window as the render target */
+void capture_frame(struct capture *c) {
+	if (c->pending)
+		capture_read_back(c, c->targets[c->current ^ 1]);
+
+	c->pending = true;
+	c->current ^= 1;
+	++ c->drawn;
+
+	SDL_SetRenderTarget(c->ren, NULL);
+}
@@ -0,0 +1,66 @@
+#ifndef CAPTURE_H_HEADER_GUARD
+#define CAPTURE_H_HEADER_GUARD
+
+#include <stdlib.h>  /* exit, EXIT_FAILURE, malloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint8_t, uint32_t */
+#include <stdio.h>   /* FILE, fopen, fclose, fwrite, fprintf, snprintf */
+#include <string.h>  /* memset, strlen, strcmp */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include "common.h"
+#include "config.h"
+
+enum capture_format {
+	CAPTURE_PNG = 0,
+	CAPTURE_Y4M,
+};
+
+/* Frames are drawn into one of two target textures, and each frame reads back the one drawn the
+ * frame before, so that the readback never waits on the frame that was just submitted. The pixels
+ * are handed to worker threads through a bounded queue, and once every buffer is in flight the
+ * render thread waits for a worker to free one. A PNG sequence is encoded by several workers at
+ * once, a Y4M stream by a single one so that the frames are written in order. */
+struct capture {
+	enum capture_format format;
+	const char         *path;
+	FILE               *file;
+
+	SDL_Renderer *ren;
+	int           w, h;
+
+	SDL_Texture *targets[2];
+	int          current;
+	bool         pending;
+	size_t       drawn, frames;
+
+	uint32_t *buffers[CAPTURE_BUFFERS];
+	int       free_buffers[CAPTURE_BUFFERS];
+	int       free_count;
+
+	struct {
+		size_t index;
+		int    buffer;
+	} queue[CAPTURE_BUFFERS];
+	size_t queue_start, queue_count;
+
+	bool        closing;
+	SDL_mutex  *lock;
+	SDL_cond   *queued, *freed;
+
+	SDL_Thread *workers[CAPTURE_MAX_WORKERS];
+	int         workers_count;
+
+	/* Only touched by the single Y4M writer */
+	uint8_t *yuv;
+};
+
+void capture_init(struct capture *c, SDL_Renderer *ren, int w, int h, const char *path);
+void capture_free(struct capture *c);
+
+SDL_Texture *capture_target(struct capture *c);
+void         capture_frame(struct capture *c);
+
+#endif
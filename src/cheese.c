@@ -1,15 +1,13 @@
 #include "cheese.h"
 
 void cheese_spawn(struct cheese *c, int x, int y) {
-	c->spawned = true;
-	c->at.x    = x;
-	c->at.y    = y;
+	c->at.x = x;
+	c->at.y = y;
 }
 
-void cheese_bite(struct cheese *c) {
-	size_t count = PARTICLES_ON_BITE;
+void cheese_bite(struct cheese *c, struct particles *particles, size_t count, size_t now) {
 	for (size_t i = 0; i < PARTICLES_CAPACITY && count > 0; ++ i) {
-		if (particle_active(&c->particles->get[i]))
+		if (particle_active(&particles->get[i], now))
 			continue;
 
 		-- count;
@@ -26,44 +24,117 @@ void cheese_bite(struct cheese *c) {
 			.h = size,
 		};
 
-		particle_start(&c->particles->get[i], vel, 0.9, angle, time,
-		               dims, CHEESE_PARTICLE_COLOR_EXPAND);
+		particle_start(&particles->get[i], vel, 0.9, angle, time,
+		               dims, CHEESE_PARTICLE_COLOR_EXPAND, now);
 	}
 }
 
-void cheese_render(struct cheese *c, SDL_Texture *texture, SDL_Renderer *ren) {
-	if (c->spawned) {
-		SDL_Rect r = {
-			.x = c->at.x * RECT_SIZE,
-			.y = c->at.y * RECT_SIZE,
-			.w = RECT_SIZE,
-			.h = RECT_SIZE,
-		};
-
-		SDL_RenderCopyShadow(ren, texture, NULL, &r, SHADOW_OFFSET / 1.5, SHADOW_ALPHA);
-		SDL_RenderCopy(ren, texture, NULL, &r);
-	}
-}
+void cheese_render(struct cheese *c, struct texture *texture, struct render_queue *q) {
+	SDL_Rect r = {
+		.x = c->at.x * RECT_SIZE,
+		.y = c->at.y * RECT_SIZE,
+		.w = RECT_SIZE,
+		.h = RECT_SIZE,
+	};
 
-void cheese_eat(struct cheese *c) {
-	c->spawned = false;
+	render_queue_copy_shadow(q, LAYER_CHEESE_SHADOW, texture->shadow, &texture->src, &r,
+	                         SHADOW_OFFSET / 1.5);
+	render_queue_copy(q, LAYER_CHEESE, texture->sdl, &texture->src, &r);
 }
 
 void cheese_pool_init(struct cheese_pool *c) {
 	particles_init(&c->particles);
 
 	memset(c->get, 0, sizeof(c->get));
-	for (size_t i = 0; i < CHEESE_CAPACITY; ++ i)
-		c->get[i].particles = &c->particles;
+	c->count = 0;
+
+	/* Hand out the low handles first */
+	c->free_count = CHEESE_CAPACITY;
+	for (size_t i = 0; i < CHEESE_CAPACITY; ++ i) {
+		c->free_handles[i] = CHEESE_CAPACITY - 1 - i;
+		c->index[i]        = CHEESE_NONE;
+	}
+}
+
+struct cheese *cheese_pool_spawn(struct cheese_pool *c, int x, int y) {
+	if (c->free_count == 0)
+		return NULL;
+
+	size_t handle = c->free_handles[-- c->free_count];
+
+	struct cheese *cheese = &c->get[c->count];
+	cheese->handle = handle;
+	cheese_spawn(cheese, x, y);
+
+	c->index[handle] = c->count ++;
+	return cheese;
+}
+
+struct cheese *cheese_pool_get(struct cheese_pool *c, size_t handle) {
+	if (handle >= CHEESE_CAPACITY || c->index[handle] == CHEESE_NONE)
+		return NULL;
+
+	return &c->get[c->index[handle]];
+}
+
+struct cheese *cheese_pool_find(struct cheese_pool *c, int x, int y) {
+	for (size_t i = 0; i < c->count; ++ i) {
+		if (c->get[i].at.x == x && c->get[i].at.y == y)
+			return &c->get[i];
+	}
+
+	return NULL;
+}
+
+/* For a pool that comes from outside, like a save. Every handle has to be either free or point at
+ * a cheese on the map that points back at it. */
+bool cheese_pool_valid(struct cheese_pool *c) {
+	if (c->count > CHEESE_CAPACITY || c->free_count != CHEESE_CAPACITY - c->count)
+		return false;
+
+	for (size_t i = 0; i < c->count; ++ i) {
+		struct cheese *cheese = &c->get[i];
+		if (cheese->handle >= CHEESE_CAPACITY || c->index[cheese->handle] != i)
+			return false;
+
+		if (cheese->at.x < 0 || cheese->at.x >= COLS || cheese->at.y < 0 || cheese->at.y >= ROWS)
+			return false;
+	}
+
+	bool seen[CHEESE_CAPACITY] = {0};
+	for (size_t i = 0; i < c->free_count; ++ i) {
+		size_t handle = c->free_handles[i];
+		if (handle >= CHEESE_CAPACITY || seen[handle] || c->index[handle] != CHEESE_NONE)
+			return false;
+
+		seen[handle] = true;
+	}
+
+	return true;
+}
+
+void cheese_pool_eat(struct cheese_pool *c, size_t handle) {
+	assert(handle < CHEESE_CAPACITY && c->index[handle] != CHEESE_NONE);
+
+	size_t i    = c->index[handle];
+	size_t last = -- c->count;
+	if (i != last) {
+		c->get[i] = c->get[last];
+		c->index[c->get[i].handle] = i;
+	}
+
+	c->index[handle] = CHEESE_NONE;
+	c->free_handles[c->free_count ++] = handle;
 }
 
-void cheese_pool_update(struct cheese_pool *c) {
-	particles_update(&c->particles);
+void cheese_pool_update(struct cheese_pool *c, size_t now) {
+	particles_update(&c->particles, now);
 }
 
-void cheese_pool_render(struct cheese_pool *c, SDL_Texture *texture, SDL_Renderer *ren) {
-	particles_render(&c->particles, ren);
+void cheese_pool_render(struct cheese_pool *c, struct texture *texture, struct render_queue *q,
+                        size_t now, size_t max_particles) {
+	particles_render(&c->particles, q, LAYER_CHEESE_PARTICLES, now, max_particles);
 
-	for (size_t i = 0; i < CHEESE_CAPACITY; ++ i)
-		cheese_render(&c->get[i], texture, ren);
+	for (size_t i = 0; i < c->count; ++ i)
+		cheese_render(&c->get[i], texture, q);
 }
@@ -6,33 +6,52 @@
 #include <SDL2/SDL.h>
 
 #include "common.h"
+#include "assets.h"
 #include "particles.h"
+#include "render_queue.h"
 #include "config.h"
 
 struct cheese {
 	SDL_Point at;
-	bool      spawned;
-
-	struct particles *particles;
+	size_t    handle;
 };
 
 #define CHEESE_PARTICLE_MIN_TIME 120
 #define CHEESE_PARTICLE_MAX_TIME 200
 
 void cheese_spawn(struct cheese *c, int x, int y);
-void cheese_bite(struct cheese *c);
-void cheese_render(struct cheese *c, SDL_Texture *texture, SDL_Renderer *ren);
-void cheese_eat(struct cheese *c);
+void cheese_bite(struct cheese *c, struct particles *particles, size_t count, size_t now);
+void cheese_render(struct cheese *c, struct texture *texture, struct render_queue *q);
+
+/* There can never be more cheese than there are cells on the map */
+#define CHEESE_CAPACITY (ROWS * COLS)
 
-#define CHEESE_CAPACITY 256
+#define CHEESE_NONE ((size_t)-1)
 
+/* Spawned cheese is kept packed in get[0 .. count - 1], eating swaps the last one into the hole.
+ * Since that moves cheese around, anything that needs to refer to a cheese for longer keeps its
+ * handle, which stays the same for as long as the cheese is not eaten. */
 struct cheese_pool {
-	struct cheese    get[CHEESE_CAPACITY];
+	struct cheese get[CHEESE_CAPACITY];
+	size_t        count;
+
+	size_t index[CHEESE_CAPACITY];
+	size_t free_handles[CHEESE_CAPACITY];
+	size_t free_count;
+
 	struct particles particles;
 };
 
 void cheese_pool_init(struct cheese_pool *c);
-void cheese_pool_update(struct cheese_pool *c);
-void cheese_pool_render(struct cheese_pool *c, SDL_Texture *texture, SDL_Renderer *ren);
+
+struct cheese *cheese_pool_spawn(struct cheese_pool *c, int x, int y);
+struct cheese *cheese_pool_get(struct cheese_pool *c, size_t handle);
+struct cheese *cheese_pool_find(struct cheese_pool *c, int x, int y);
+bool           cheese_pool_valid(struct cheese_pool *c);
+void           cheese_pool_eat(struct cheese_pool *c, size_t handle);
+
+void cheese_pool_update(struct cheese_pool *c, size_t now);
+void cheese_pool_render(struct cheese_pool *c, struct texture *texture, struct render_queue *q,
+                        size_t now, size_t max_particles);
 
 #endif
@@ -31,21 +31,60 @@ void iswap(int *a, int *b) {
 	*b = tmp;
 }
 
-void SDL_RenderCopyShadowEx(SDL_Renderer *ren, SDL_Texture *texture,
-                            SDL_Rect *src, SDL_Rect *dest, double angle,
-                            SDL_Point *center, SDL_RendererFlip flip, int offset, int a) {
-	SDL_Rect r = *dest;
-	r.x += offset;
-	r.y += offset;
-
-	SDL_SetTextureColorMod(texture, 0, 0, 0);
-	SDL_SetTextureAlphaMod(texture, a);
-	SDL_RenderCopyEx(ren, texture, src, &r, angle, center, flip);
-	SDL_SetTextureColorMod(texture, 255, 255, 255);
-	SDL_SetTextureAlphaMod(texture, 255);
-}
-
-void SDL_RenderCopyShadow(SDL_Renderer *ren, SDL_Texture *texture,
-                          SDL_Rect *src, SDL_Rect *dest, int offset, int a) {
-	SDL_RenderCopyShadowEx(ren, texture, src, dest, 0, NULL, SDL_FLIP_NONE, offset, a);
+int compare_u32(const void *a_, const void *b_) {
+	uint32_t a = *(const uint32_t*)a_;
+	uint32_t b = *(const uint32_t*)b_;
+
+	return a < b? -1 : a > b;
+}
+
+bool arg_flag(const char *name) {
+	for (int i = 1; i < argc; ++ i) {
+		if (strcmp(argv[i], name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/* The argument right after the name, or NULL if there is none */
+const char *arg_value(const char *name) {
+	for (int i = 1; i < argc - 1; ++ i) {
+		if (strcmp(argv[i], name) == 0)
+			return argv[i + 1];
+	}
+
+	return NULL;
+}
+
+/* Bakes a black silhouette of the surface with its alpha scaled by a, so that shadows can be drawn
+ * with a plain copy instead of toggling the colour and alpha mod of the original texture */
+SDL_Surface *SDL_CreateShadowSurface(SDL_Surface *surface, int a) {
+	SDL_Surface *s = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (s == NULL)
+		return NULL;
+
+	SDL_LockSurface(s);
+	for (int y = 0; y < s->h; ++ y) {
+		Uint32 *px = (Uint32*)((Uint8*)s->pixels + y * s->pitch);
+
+		for (int x = 0; x < s->w; ++ x)
+			px[x] = (px[x] >> 24) * a / 255 << 24;
+	}
+	SDL_UnlockSurface(s);
+
+	return s;
+}
+
+SDL_Texture *SDL_CreateShadowTextureFromSurface(SDL_Renderer *ren, SDL_Surface *surface, int a) {
+	SDL_Surface *s = SDL_CreateShadowSurface(surface, a);
+	if (s == NULL)
+		return NULL;
+
+	SDL_Texture *shadow = SDL_CreateTextureFromSurface(ren, s);
+	if (shadow != NULL)
+		SDL_SetTextureBlendMode(shadow, SDL_BLENDMODE_BLEND);
+
+	SDL_FreeSurface(s);
+	return shadow;
 }
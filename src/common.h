@@ -1,9 +1,12 @@
 #ifndef COMMON_H_HEADER_GUARD
 #define COMMON_H_HEADER_GUARD
 
-#include <math.h>   /* pow, floor */
-#include <assert.h> /* assert */
-#include <stdlib.h> /* rand */
+#include <math.h>    /* pow, floor */
+#include <assert.h>  /* assert */
+#include <stdlib.h>  /* rand */
+#include <stdbool.h> /* bool, true, false */
+#include <string.h>  /* strcmp */
+#include <stdint.h>  /* uint32_t */
 
 #include <SDL2/SDL.h>
 
@@ -27,10 +30,13 @@ float rand_frange(float min, float max, int precision);
 
 void iswap(int *a, int *b);
 
-void SDL_RenderCopyShadowEx(SDL_Renderer *ren, SDL_Texture *texture,
-                            SDL_Rect *src, SDL_Rect *dest, double angle,
-                            SDL_Point *center, SDL_RendererFlip flip, int offset, int a);
-void SDL_RenderCopyShadow(SDL_Renderer *ren, SDL_Texture *texture,
-                          SDL_Rect *src, SDL_Rect *dest, int offset, int a);
+/* For qsort() on arrays of uint32_t */
+int compare_u32(const void *a, const void *b);
+
+bool        arg_flag(const char *name);
+const char *arg_value(const char *name);
+
+SDL_Surface *SDL_CreateShadowSurface(SDL_Surface *surface, int a);
+SDL_Texture *SDL_CreateShadowTextureFromSurface(SDL_Renderer *ren, SDL_Surface *surface, int a);
 
 #endif
@@ -24,8 +24,67 @@
 #define WIN_W (MAP_W)
 #define WIN_H (MAP_H + PADDING * 2 + INFO_H)
 
+#define TICK_RATE     60
+#define MAX_CATCH_UP  5
+
+/* While nothing but the banners moves, or the window is hidden, a frame is only drawn every
+ * IDLE_FRAME_TICKS ticks, and both threads sleep in between */
+#define IDLE_FRAME_TICKS 6
+
 #define CHEESE_SPAWN_TICK_DELAY 150
 
+#define REWIND_SECONDS        10
+#define REWIND_KEYFRAME_TICKS 30
+#define REWIND_STEP           TICK_RATE
+
+#define SAVE_PATH "cnake.sav"
+
+#define TELEMETRY_SAMPLE_TICKS TICK_RATE
+
+#define JOBS_MAX_WORKERS 6
+
+#define PARTICLES_JOB_GRAIN 64
+
+/* Every tick, the AI runs batches of rollouts for as long as its budget lasts, split between the
+ * cells the snake crosses on it. A rollout plays AI_ROLLOUT_DEPTH cells ahead, with everything
+ * further away counting AI_DISCOUNT times less. */
+#define AI_BUDGET_US      4000
+#define AI_BATCH_ROLLOUTS 256
+#define AI_ROLLOUT_GRAIN  16
+#define AI_ROLLOUT_DEPTH  40
+#define AI_DEATH_PENALTY  20
+#define AI_DISCOUNT       0.95
+
+/* The Hamiltonian cycle AI only cuts across while the snake fills less than 1 / HAMILTON_SHORTCUT_DIV
+ * of the map, and keeps HAMILTON_SLACK cells of room ahead of the tail on top of what it grows by */
+#define HAMILTON_SHORTCUT_DIV 2
+#define HAMILTON_SLACK        2
+
+/* A bot gets BOT_DEADLINE_MS per tick to answer in, however many cells the snake crosses on it */
+#define BOTS_CAPACITY         4
+#define BOT_DEADLINE_MS       2
+#define BOT_UNLOAD_TIMEOUT_MS 1000
+#define BOT_LATENCY_WINDOW    1024
+
+/* The quality goes down when the 95th percentile of a QUALITY_WINDOW frames long window of render
+ * times is over the budget, and back up after QUALITY_UP_WINDOWS windows in a row under half of it */
+#define QUALITY_WINDOW     TICK_RATE
+#define QUALITY_BUDGET_US  8000
+#define QUALITY_UP_WINDOWS 5
+
+/* Sessions beyond the capacity are turned away. A client that reads too slowly misses updates
+ * instead of holding the server up, and gets the latest state once it catches up. The capacity
+ * shrinks to fit the open files limit, minus SERVER_RESERVED_FDS for everything else. */
+#define SERVER_SESSIONS_CAPACITY 4096
+#define SERVER_EVENTS            256
+#define SERVER_BACKLOG           128
+#define SERVER_RESERVED_FDS      32
+
+#define CAPTURE_BUFFERS     8
+#define CAPTURE_MAX_WORKERS 4
+
+#define SOUNDS_BUDGET (256 * 1024)
+
 #define SHADOW_OFFSET 5
 #define SHADOW_ALPHA  40
 
@@ -1,202 +1,411 @@
 #include "game.h"
 
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-#	define PLATFORM_WINDOWS
-#elif defined(__APPLE__)
-#	define PLATFORM_APPLE
-#elif defined(__linux__) || defined(__gnu_linux__) || defined(linux)
-#	define PLATFORM_LINUX
-#elif defined(__unix__) || defined(unix)
-#	define PLATFORM_UNIX
-#else
-#	define PLATFORM_UNKNOWN
-#endif
-
-#ifdef PLATFORM_LINUX
-# 	define D_POSIX_C_SOURCE 200809L
-#	include <unistd.h>
-#endif
+static_assert(TRACE_MAX_THREADS >= JOBS_MAX_WORKERS + 4,
+              "The main, simulation, audio and fonts threads and every worker have to fit the trace");
 
-#ifdef PLATFORM_WINDOWS
-#	include <windows.h>
-
-#	ifndef MAX_PATH
-#		define PATH_MAX 1024
-#	else
-#		define PATH_MAX MAX_PATH
-#	endif
-#else
-#	ifndef PATH_MAX
-#		define PATH_MAX 1024
-#	endif
-#endif
+static size_t timer_times[TIMERS_COUNT] = {
+	[TIMER_SCR_SHAKE]  = SCR_SHAKE_TIME,
+	[TIMER_FADE_IN]    = FADE_IN_TIME,
+	[TIMER_FADE_OUT]   = FADE_OUT_TIME,
+	[TIMER_DEAD]       = DEAD_TIME,
+	[TIMER_TRANSITION] = TRANSITION_TIME,
+};
 
-static char *get_exec_folder_path(void) {
-	char *buf = (char*)malloc(PATH_MAX);
-	if (buf == NULL)
-		UNREACHABLE("malloc() fail");
+/* The screen shake belongs to the gameplay and stops along with it, the rest are UI */
+static bool timer_on_play_clock[TIMERS_COUNT] = {
+	[TIMER_SCR_SHAKE] = true,
+};
 
-#if defined(PLATFORM_LINUX)
-	ssize_t len = readlink("/proc/self/exe", buf, PATH_MAX);
-	if (len != -1)
-		buf[len] = '\0';
-	else
-		strcpy(buf, argv[0]);
-#elif defined(PLATFORM_APPLE)
-	uint32_t len = PATH_MAX;
-	if (_NSGetExecutablePath(buf, &len) != 0)
-		strcpy(buf, argv[0]);
-#elif defined(PLATFORM_WINDOWS)
-	GetModuleFileName(NULL, buf, PATH_MAX);
-#else
-	strcpy(buf, argv[0]);
-#endif
+/* Assets that each state is about to draw or play, loaded ahead of time on a state change so that
+ * the first frame of the new state does not have to wait for the disk. Sounds are prefetched by the
+ * simulation thread as it changes the state, textures by the render thread once it sees it. */
+static uint32_t state_prefetch_textures[] = {
+	[STATE_QUIT]     = 0,
+	[STATE_GAMEPLAY] = ASSET_BIT(TEXTURE_EYES)   | ASSET_BIT(TEXTURE_TONGUE) |
+	                   ASSET_BIT(TEXTURE_GRASS1) | ASSET_BIT(TEXTURE_GRASS2) |
+	                   ASSET_BIT(TEXTURE_CHEESE),
+	[STATE_PAUSED]   = ASSET_BIT(TEXTURE_PAUSED),
+	[STATE_TUTORIAL] = ASSET_BIT(TEXTURE_TUTORIAL),
+	[STATE_DEAD]     = ASSET_BIT(TEXTURE_EYES_DEAD) | ASSET_BIT(TEXTURE_YOU_LOST) |
+	                   ASSET_BIT(TEXTURE_SPACEBAR),
+};
 
-#if defined(PLATFORM_LINUX)
-	ssize_t i = len - 1;
-#elif defined(PLATFORM_APPLE)
-	uint32_t i = len - 1;
-#elif defined(PLATFORM_WINDOWS)
-	size_t i = len - 1;
-#endif
+static uint32_t state_prefetch_sounds[] = {
+	[STATE_QUIT]     = 0,
+	[STATE_GAMEPLAY] = ASSET_BIT(SOUND_EAT) | ASSET_BIT(SOUND_HIT) | ASSET_BIT(SOUND_DEATH),
+	[STATE_PAUSED]   = 0,
+	[STATE_TUTORIAL] = 0,
+	[STATE_DEAD]     = 0,
+};
 
-	for (; i > 0; -- i) {
-		if (buf[i] == '/' || buf[i] == '\\') {
-			buf[i] = '\0';
-			break;
-		}
-	}
+static struct timer_wheel *game_timer_clock(struct game_state *s, int timer) {
+	return timer_on_play_clock[timer]? &s->play_clock : &s->ui_clock;
+}
 
-	return buf;
+static void game_timer_start(struct game *g, int timer) {
+	timer_start(&g->sim.get_timer[timer], game_timer_clock(&g->sim, timer));
 }
 
-static void game_load_texture(struct game *g, int key, const char *path) {
-	SDL_Surface *s = IMG_Load(path);
-	if (s == NULL) {
-		SDL_Log("%s", SDL_GetError());
-		exit(EXIT_FAILURE);
-	}
+static bool game_timer_active(struct game_state *s, int timer) {
+	return timer_active(&s->get_timer[timer], game_timer_clock(s, timer)->now);
+}
 
-	struct texture *texture = &g->get_texture[key];
-	texture->sdl = SDL_CreateTextureFromSurface(g->ren, s);
-	if (texture->sdl == NULL) {
-		SDL_Log("%s", SDL_GetError());
-		exit(EXIT_FAILURE);
-	}
-	SDL_QueryTexture(texture->sdl, NULL, NULL, &texture->w, &texture->h);
+static float game_timer_unit(struct game_state *s, int timer, bool reverse) {
+	return timer_unit(&s->get_timer[timer], game_timer_clock(s, timer)->now, reverse);
+}
 
-	SDL_FreeSurface(s);
-	SDL_Log("Loaded texture from '%s'", path);
+static bool game_audio_ready(struct game *g) {
+	return SDL_AtomicGet(&g->audio_ready);
 }
 
-static void game_load_sound(struct game *g, int key, const char *path) {
-	g->get_sound[key] = Mix_LoadWAV(path);
-	if (g->get_sound[key] == NULL) {
-		SDL_Log("%s", SDL_GetError());
-		exit(EXIT_FAILURE);
-	}
+static uint32_t game_us_since(Uint64 start) {
+	return (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+}
 
-	SDL_Log("Loaded sound from '%s'", path);
+static double game_ms_since_start(struct game *g) {
+	return (double)(SDL_GetPerformanceCounter() - g->started) * 1000 / SDL_GetPerformanceFrequency();
 }
 
-static size_t timer_times[TIMERS_COUNT] = {
-	[TIMER_SCR_SHAKE]  = SCR_SHAKE_TIME,
-	[TIMER_FADE_IN]    = FADE_IN_TIME,
-	[TIMER_FADE_OUT]   = FADE_OUT_TIME,
-	[TIMER_DEAD]       = DEAD_TIME,
-	[TIMER_TRANSITION] = TRANSITION_TIME,
-};
+static void game_set_state(struct game *g, enum state state) {
+	g->sim.state = state;
+	if (game_audio_ready(g))
+		assets_prefetch(&g->assets, 0, state_prefetch_sounds[state]);
+}
 
-#define ASSETS_FOLDER "cnake_assets"
-
-static char *texture_paths[TEXTURES_COUNT] = {
-	[TEXTURE_EYES]      = ASSETS_FOLDER"/imgs/eyes.png",
-	[TEXTURE_EYES_DEAD] = ASSETS_FOLDER"/imgs/eyes_dead.png",
-	[TEXTURE_TONGUE]    = ASSETS_FOLDER"/imgs/tongue.png",
-	[TEXTURE_GRASS1]    = ASSETS_FOLDER"/imgs/grass1.png",
-	[TEXTURE_GRASS2]    = ASSETS_FOLDER"/imgs/grass2.png",
-	[TEXTURE_CHEESE]    = ASSETS_FOLDER"/imgs/cheese.png",
-	[TEXTURE_TUTORIAL]  = ASSETS_FOLDER"/imgs/tutorial.png",
-	[TEXTURE_PAUSED]    = ASSETS_FOLDER"/imgs/paused.png",
-	[TEXTURE_YOU_LOST]  = ASSETS_FOLDER"/imgs/you_lost.png",
-	[TEXTURE_SPACEBAR]  = ASSETS_FOLDER"/imgs/spacebar.png",
-};
+static struct texture *game_texture(struct game *g, int key) {
+	return assets_texture(&g->assets, key);
+}
 
-static char *sound_paths[SOUNDS_COUNT] = {
-	[SOUND_EAT]          = ASSETS_FOLDER"/sfx/eat.wav",
-	[SOUND_HIT]          = ASSETS_FOLDER"/sfx/hit.wav",
-	[SOUND_DEATH]        = ASSETS_FOLDER"/sfx/death.wav",
-	[SOUND_CHEESEBURGER] = ASSETS_FOLDER"/sfx/cheeseburger.wav",
-};
+static SDL_Surface *game_texture_pixels(void *data, SDL_Texture *texture) {
+	return assets_texture_pixels((struct assets*)data, texture);
+}
 
-static char *prefix_path(const char *path, const char *prefix) {
-	size_t size = strlen(prefix) + strlen(path) + 2;
-	char  *buf  = (char*)malloc(size);
-	memset(buf, 0, size);
+/* Sounds are skipped until the audio device is open */
+static void game_play_sound(struct game *g, int key) {
+	if (game_audio_ready(g))
+		Mix_PlayChannel(1, assets_sound(&g->assets, key), 0);
+}
 
-	strcat(buf, prefix);
-	strcat(buf, "/");
-	strcat(buf, path);
+static const struct quality_settings *game_quality(struct game *g) {
+	return quality_settings(quality_level(&g->quality));
+}
 
-	return buf;
+/* How many of count particles the current quality emits */
+static size_t game_particles_count(struct game *g, size_t count) {
+	return (size_t)(count * game_quality(g)->particles + 0.5);
 }
 
-static void game_load_font(struct game *g, const char *exec_folder_path) {
-	char *path = prefix_path(ASSETS_FOLDER"/fonts/deja_vu_sans.tff", exec_folder_path);
+static void game_emit_snake_particles_at(struct game *g, int x, int y, size_t count) {
+	for (size_t i = 0; i < PARTICLES_CAPACITY && count > 0; ++ i) {
+		if (particle_active(&g->sim.particles.get[i], g->sim.play_clock.now))
+			continue;
 
-	g->font = TTF_OpenFont(path, SCORE_FONT_SIZE * 2);
-	if (g->font == NULL) {
-		SDL_Log("%s", SDL_GetError());
-		exit(EXIT_FAILURE);
-	} else
-		SDL_Log("Loaded font from '%s'", path);
+		-- count;
+
+		float  vel   = rand_frange(PARTICLE_MIN_VEL, PARTICLE_MAX_VEL, 2);
+		float  angle = rand_irange(0, 360 - 1);
+		size_t time  = rand_irange(PARTICLE_MIN_TIME, PARTICLE_MAX_TIME);
+		int    size  = rand_irange(PARTICLE_MIN_SIZE, PARTICLE_MAX_SIZE);
+
+		SDL_Rect dims = {
+			.x = rand_irange(x * RECT_SIZE, (x + 1) * RECT_SIZE),
+			.y = rand_irange(y * RECT_SIZE, (y + 1) * RECT_SIZE),
+			.w = size,
+			.h = size,
+		};
 
-	free(path);
+		particle_start(&g->sim.particles.get[i], vel, 0.95, angle, time,
+		               dims, SNAKE_PARTICLE_COLOR_EXPAND, g->sim.play_clock.now);
+	}
 }
 
-static void game_load_assets(struct game *g) {
-	char  *exec_folder_path = get_exec_folder_path();
+/* Lays the scenario over the board that was just set up, spawning cheese through the pool and
+ * starting timers through the clocks so that everything stays consistent */
+static void game_apply_scenario(struct game *g) {
+	struct scenario *s = &g->scenario;
+
+	if (s->len > 0) {
+		struct snake *snake = &g->sim.snake;
+		snake->dir = s->dir;
+		snake_set_body(snake, s->body, s->len);
 
-	for (size_t i = 0; i < TEXTURES_COUNT; ++ i) {
-		char *path = prefix_path(texture_paths[i], exec_folder_path);
-		game_load_texture(g, i, path);
-		free(path);
+		/* The cell the tail just left, behind it */
+		SDL_Point tail = s->body[s->len - 1], before = s->body[s->len - 2];
+		snake->prev.x = tail.x * 2 - before.x;
+		snake->prev.y = tail.y * 2 - before.y;
 	}
 
-	for (size_t i = 0; i < SOUNDS_COUNT; ++ i) {
-		char *path = prefix_path(sound_paths[i], exec_folder_path);
-		game_load_sound(g, i, path);
-		free(path);
+	for (size_t i = 0; i < s->cheese_count; ++ i)
+		cheese_pool_spawn(&g->sim.cheese_pool, s->cheese[i].x, s->cheese[i].y);
+
+	g->sim.score         = s->score;
+	g->sim.darken_screen = s->state != STATE_GAMEPLAY;
+	g->sim.snake.dead    = s->state == STATE_DEAD;
+	game_set_state(g, s->state);
+
+	struct snake *snake = &g->sim.snake;
+	SDL_Point     cells[MAX_SNAKE_LEN];
+	snake_cells(snake, cells);
+	for (size_t i = 0; i < s->snake_particles; ++ i)
+		game_emit_snake_particles_at(g, cells[i % snake->len].x, cells[i % snake->len].y, 1);
+
+	struct cheese_pool *pool = &g->sim.cheese_pool;
+	for (size_t i = 0; pool->count > 0 && i < s->cheese_particles; i += PARTICLES_ON_BITE)
+		cheese_bite(&pool->get[i % pool->count], &pool->particles, PARTICLES_ON_BITE,
+		            g->sim.ui_clock.now);
+
+	for (size_t i = 0; i < TIMERS_COUNT; ++ i) {
+		if (s->timers & (uint32_t)1 << i)
+			game_timer_start(g, i);
 	}
+}
 
-	game_load_font(g, exec_folder_path);
+static void game_telemetry(struct game *g, enum telemetry_kind kind, uint32_t a, uint32_t b) {
+	if (!g->logging_telemetry)
+		return;
 
-	free(exec_folder_path);
+	struct telemetry_record record = {
+		.kind   = kind,
+		.game   = g->games,
+		.tick   = g->sim.tick,
+		.values = {a, b},
+	};
+	telemetry_log(&g->telemetry, TELEMETRY_SIM, &record);
 }
 
 static void game_restart(struct game *g) {
-	g->darken_screen = true;
-	g->state         = STATE_TUTORIAL;
-	g->score         = 0;
-
-	struct snake_textures textures = {
-		.eyes      = g->get_texture[TEXTURE_EYES].sdl,
-		.eyes_dead = g->get_texture[TEXTURE_EYES_DEAD].sdl,
-		.tongue    = g->get_texture[TEXTURE_TONGUE].sdl,
-	};
+	g->sim.darken_screen = true;
+	g->sim.score         = 0;
+	game_set_state(g, STATE_TUTORIAL);
 
 	SDL_Point start = {
 		.x = 5,
 		.y = ROWS / 2,
 	};
 
-	snake_init(&g->snake, start, textures, SNAKE_COLOR_EXPAND);
-	cheese_pool_init(&g->cheese_pool);
+	/* A new game starts on a fresh gameplay clock, with nothing of the old one left running */
+	timer_wheel_init(&g->sim.play_clock);
+	particles_init(&g->sim.particles);
+
+	for (size_t i = 0; i < TIMERS_COUNT; ++ i) {
+		if (timer_on_play_clock[i])
+			timer_init(&g->sim.get_timer[i], timer_times[i], i);
+	}
+
+	g->sim.map_shake_pos.x = 0;
+	g->sim.map_shake_pos.y = 0;
+
+	snake_init(&g->sim.snake, start, SNAKE_COLOR_EXPAND, &g->sim.play_clock, TIMER_SNAKE_TONGUE);
+	cheese_pool_init(&g->sim.cheese_pool);
+
+	if (g->has_scenario)
+		game_apply_scenario(g);
+
+	++ g->games;
+	game_telemetry(g, TELEMETRY_GAME_START, g->sim.snake.len, g->sim.score);
+
+	/* The bots take turns, one game each */
+	if (g->bots_count > 0)
+		g->bot = (g->games - 1) % g->bots_count;
+}
+
+/* Nothing changes from one tick to the next but the banners bobbing, as long as no one but the
+ * player is pressing keys */
+static bool game_idle(struct game *g, struct game_state *s) {
+	if (g->lockstep || g->ai || g->bots_count > 0)
+		return false;
+
+	switch (s->state) {
+	case STATE_PAUSED:
+	case STATE_TUTORIAL: break;
+	case STATE_DEAD:
+		if (!s->darken_screen)
+			return false;
+
+		break;
+
+	default: return false;
+	}
+
+	for (int i = 0; i < TIMERS_COUNT; ++ i) {
+		if (game_timer_active(s, i))
+			return false;
+	}
+
+	return !particles_active(&s->particles, s->play_clock.now) &&
+	       !particles_active(&s->cheese_pool.particles, s->ui_clock.now);
+}
+
+static void game_publish(struct game *g) {
+	memcpy(triple_buffer_write(&g->snapshots), &g->sim, sizeof(g->sim));
+	triple_buffer_publish(&g->snapshots);
+
+	if (SDL_SemValue(g->published) == 0)
+		SDL_SemPost(g->published);
+}
+
+/* Runs the simulation at a fixed TICK_RATE, independent of how long rendering and presenting take */
+static int game_simulate(void *data) {
+	struct game *g = (struct game*)data;
+	trace_thread("simulation");
+
+	Uint64 freq = SDL_GetPerformanceFrequency();
+	Uint64 step = freq / TICK_RATE;
+	Uint64 next = SDL_GetPerformanceCounter();
+	bool   idle = false;
+
+	while (game_running(g)) {
+		if (g->lockstep) {
+			if (SDL_SemWaitTimeout(g->consumed, 100) == 0) {
+				game_update(g);
+				game_publish(g);
+			}
+
+			continue;
+		}
+
+		/* A key press while idle is handled right away, instead of at the end of the idle frame */
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now < next) {
+			/* Rounded up, so that less than a millisecond left still sleeps instead of polling */
+			Uint32 ms = ((next - now) * 1000 + freq - 1) / freq;
+			if (SDL_SemWaitTimeout(g->woken, ms) == 0 && idle)
+				next = now;
+
+			continue;
+		}
+
+		game_update(g);
+		next += step;
+
+		/* While idle, the ticks of a whole frame run back to back and are published together, so
+		 * that the thread sleeps through the rest of it */
+		idle = game_idle(g, &g->sim);
+		for (size_t i = 1; idle && i < IDLE_FRAME_TICKS; ++ i) {
+			game_update(g);
+			next += step;
+			idle = game_idle(g, &g->sim);
+		}
+
+		game_publish(g);
+
+		/* After a long stall, drop the missed ticks instead of trying to run all of them at once */
+		if (now > next + step * MAX_CATCH_UP)
+			next = now;
+	}
+
+	return 0;
+}
+
+/* Opening the audio device alone can take hundreds of milliseconds on some hosts */
+static int game_init_audio(void *data) {
+	struct game *g = (struct game*)data;
+	Uint64 start = trace_begin();
+
+	/* The rest of the game is already running by now, it just goes on without sound */
+	if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 200) < 0) {
+		SDL_Log("Could not open audio, playing without sound: %s", SDL_GetError());
+		trace_end("game_init_audio", start);
+		return 0;
+	} else
+		SDL_Log("Initialized SDL_mixer after %.1f ms", game_ms_since_start(g));
+
+	SDL_AtomicSet(&g->audio_ready, true);
+	trace_end("game_init_audio", start);
+	return 0;
 }
 
+static int game_init_fonts(void *data) {
+	struct game *g = (struct game*)data;
+	Uint64 start = trace_begin();
+
+	/* Like with the audio, the game goes on without the score text instead of quitting */
+	if (TTF_Init() < 0) {
+		SDL_Log("Could not initialize SDL_ttf, playing without text: %s", SDL_GetError());
+		trace_end("game_init_fonts", start);
+		return 0;
+	} else
+		SDL_Log("Initialized SDL_ttf");
+
+	if (!assets_load_font(&g->assets)) {
+		SDL_Log("Playing without text");
+		trace_end("game_init_fonts", start);
+		return 0;
+	}
+	SDL_Log("Loaded the font after %.1f ms", game_ms_since_start(g));
+
+	SDL_AtomicSet(&g->fonts_ready, true);
+	trace_end("game_init_fonts", start);
+	return 0;
+}
+
+/* Only video is set up here, everything else that is slow to start happens in the background,
+ * so that the first frame shows up as soon as there is a window to show it in */
 void game_init(struct game *g) {
 	memset(g, 0, sizeof(*g));
 	srand(time(NULL));
+	g->started = SDL_GetPerformanceCounter();
+
+	const char *capture_path  = arg_value("--capture");
+	const char *capture_limit = arg_value("--capture-frames");
+
+	g->headless      = arg_flag("--headless");
+	g->capturing     = capture_path != NULL;
+	g->capture_limit = capture_limit != NULL? strtoul(capture_limit, NULL, 10) : 0;
+	g->lockstep      = g->capturing || arg_flag("--lockstep");
+
+	/* Before anything that is traced, so that startup shows up too */
+	const char *trace_path = arg_value("--trace");
+	if (trace_path != NULL) {
+		trace_init(trace_path);
+		trace_thread("main");
+	}
+
+	const char *scenario_path = arg_value("--scenario");
+	g->has_scenario = scenario_path != NULL;
+	if (g->has_scenario && !scenario_load(&g->scenario, scenario_path))
+		exit(EXIT_FAILURE);
+
+	/* So that the same scenario always plays out the same */
+	if (g->has_scenario)
+		srand(g->scenario.seed);
+
+	/* Above one cell per tick, the snake crosses several cells on every tick */
+	const char *speed = arg_value("--speed");
+	g->speed = speed != NULL? strtof(speed, NULL) : 1;
+	if (g->speed <= 0) {
+		SDL_Log("Invalid speed '%s'", speed);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Runs in lockstep keep to one level, so that the same run renders the same frames */
+	const char *quality = arg_value("--quality");
+	g->governed = quality == NULL && !g->lockstep;
+	quality_init(&g->quality, QUALITY_HIGH);
+	if (quality != NULL) {
+		int level = QUALITY_LEVELS;
+		for (int i = 0; i < QUALITY_LEVELS; ++ i) {
+			if (strcmp(quality, quality_settings(i)->name) == 0)
+				level = i;
+		}
+
+		if (level == QUALITY_LEVELS) {
+			SDL_Log("Invalid quality '%s'", quality);
+			exit(EXIT_FAILURE);
+		}
+
+		quality_init(&g->quality, level);
+	}
+
+	g->save_path = arg_value("--save");
+	if (g->save_path == NULL)
+		g->save_path = SAVE_PATH;
+
+	/* Off-screen, with nothing to show or play the frames on */
+	if (g->headless) {
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", true);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", true);
+	}
 
 	if (SDL_Init(SDL_INIT_VIDEO) < 0) {
 		SDL_Log("%s", SDL_GetError());
@@ -210,20 +419,14 @@ void game_init(struct game *g) {
 	} else
 		SDL_Log("Initialized SDL_image");
 
-	if (TTF_Init() < 0) {
-		SDL_Log("%s", SDL_GetError());
-		exit(EXIT_FAILURE);
-	} else
-		SDL_Log("Initialized SDL_ttf");
-
-	if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 200) < 0) {
+	g->audio_thread = SDL_CreateThread(game_init_audio, "init audio", g);
+	if (g->audio_thread == NULL) {
 		SDL_Log("%s", SDL_GetError());
 		exit(EXIT_FAILURE);
-	} else
-		SDL_Log("Initialized SDL_mixer");
+	}
 
 	g->win = SDL_CreateWindow(TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-	                          WIN_W, WIN_H, SDL_WINDOW_SHOWN);
+	                          WIN_W, WIN_H, g->headless? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
 	if (g->win == NULL) {
 		SDL_Log("%s", SDL_GetError());
 		exit(EXIT_FAILURE);
@@ -237,8 +440,17 @@ void game_init(struct game *g) {
 	} else
 		SDL_Log("Created the renderer");
 
-	g->map = SDL_CreateTexture(g->ren, SDL_PIXELFORMAT_RGBA8888,
-	                           SDL_TEXTUREACCESS_TARGET, MAP_W, MAP_H);
+	/* Without a GPU, SDL falls back to its own software renderer anyway */
+	SDL_RendererInfo info;
+	g->software = arg_flag("--software") ||
+	              (SDL_GetRendererInfo(g->ren, &info) == 0 && info.flags & SDL_RENDERER_SOFTWARE);
+
+	if (g->software)
+		g->map = SDL_CreateTexture(g->ren, SDL_PIXELFORMAT_ARGB8888,
+		                           SDL_TEXTUREACCESS_STREAMING, MAP_W, MAP_H);
+	else
+		g->map = SDL_CreateTexture(g->ren, SDL_PIXELFORMAT_RGBA8888,
+		                           SDL_TEXTUREACCESS_TARGET, MAP_W, MAP_H);
 	if (g->map == NULL) {
 		SDL_Log("%s", SDL_GetError());
 		exit(EXIT_FAILURE);
@@ -251,11 +463,12 @@ void game_init(struct game *g) {
 	} else
 		SDL_Log("Render draw blend mode was set");
 
-	if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear")) {
+	const char *scale_quality = game_quality(g)->linear? "linear" : "nearest";
+	if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, scale_quality)) {
 		SDL_Log("%s", SDL_GetError());
 		exit(EXIT_FAILURE);
 	} else
-		SDL_Log("Hint 'linear' for SDL_HINT_RENDER_SCALE_QUALITY was set");
+		SDL_Log("Hint '%s' for SDL_HINT_RENDER_SCALE_QUALITY was set", scale_quality);
 
 	if (SDL_RenderSetLogicalSize(g->ren, WIN_W, WIN_H) != 0) {
 		SDL_Log("%s", SDL_GetError());
@@ -270,37 +483,167 @@ void game_init(struct game *g) {
 	g->map_rect.w = MAP_W;
 	g->map_rect.h = MAP_H;
 
-	game_load_assets(g);
+	assets_init(&g->assets, g->ren, g->software);
+
+	g->fonts_thread = SDL_CreateThread(game_init_fonts, "init fonts", g);
+	if (g->fonts_thread == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+	render_queue_init(&g->queue, g->ren);
+	for (size_t i = 0; i < MAP_QUEUES_COUNT; ++ i)
+		render_queue_init(&g->map_queues[i], NULL);
+
+	const char *workers = arg_value("--workers");
+	jobs_init(&g->jobs, workers != NULL? atoi(workers) : SDL_GetCPUCount() - 1);
+	SDL_Log("Started %i job worker(s)", g->jobs.workers_count);
+
+	g->hamilton = arg_flag("--hamilton");
+	g->ai       = g->hamilton || arg_flag("--ai");
+	if (g->hamilton) {
+		hamilton_init(&g->cycle);
+		SDL_Log("The Hamiltonian cycle AI is playing");
+	} else if (g->ai) {
+		planner_init(&g->planner, &g->jobs, rand());
+		SDL_Log("The AI is playing");
+	}
+
+	/* A comma separated list of shared objects */
+	const char *bots = arg_value("--bot");
+	if (bots != NULL) {
+		g->bot_paths = SDL_strdup(bots);
+
+		char *save = NULL;
+		for (char *path = SDL_strtokr(g->bot_paths, ",", &save); path != NULL;
+		     path = SDL_strtokr(NULL, ",", &save)) {
+			if (g->bots_count >= BOTS_CAPACITY) {
+				SDL_Log("Too many bots, only the first %i are loaded", BOTS_CAPACITY);
+				break;
+			}
+
+			bot_load(&g->bots[g->bots_count ++], path);
+		}
+	}
 
-	SDL_Log("Loaded assets");
+	if (g->software) {
+		softrast_init(&g->soft, MAP_W, MAP_H, game_texture_pixels, &g->assets);
+		SDL_Log("Initialized the software rasteriser");
+	}
 
-	particles_init(&g->particles);
+	if (g->capturing)
+		capture_init(&g->capture, g->ren, WIN_W, WIN_H, capture_path);
 
+	SDL_Log("Initialized assets");
+
+	const char *telemetry_path = arg_value("--telemetry");
+	g->logging_telemetry = telemetry_path != NULL;
+	if (g->logging_telemetry)
+		telemetry_init(&g->telemetry, telemetry_path);
+
+	timer_wheel_init(&g->sim.ui_clock);
 	for (size_t i = 0; i < TIMERS_COUNT; ++ i)
-		timer_init(&g->get_timer[i], timer_times[i]);
+		timer_init(&g->sim.get_timer[i], timer_times[i], i);
 
 	game_restart(g);
 
+	input_queue_init(&g->input);
+	rewind_init(&g->rewind, sizeof(g->sim));
+
+	/* The first snapshot is taken below, so the first tick does not have to wait for a frame */
+	g->published = SDL_CreateSemaphore(0);
+	g->consumed  = SDL_CreateSemaphore(1);
+	g->woken     = SDL_CreateSemaphore(0);
+	if (g->published == NULL || g->consumed == NULL || g->woken == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	triple_buffer_init(&g->snapshots, sizeof(g->sim));
+	game_publish(g);
+
+	bool fresh;
+	g->view           = (struct game_state*)triple_buffer_read(&g->snapshots, &fresh);
+	g->rendered_state = STATE_QUIT;
+
+	g->sim_thread = SDL_CreateThread(game_simulate, "simulation", g);
+	if (g->sim_thread == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	} else
+		SDL_Log("Started the simulation thread");
+
 	SDL_Log("Initialized");
 }
 
-void game_free_assets(struct game *g) {
-	for (size_t i = 0; i < TEXTURES_COUNT; ++ i)
-		SDL_DestroyTexture(g->get_texture[i].sdl);
+bool game_running(struct game *g) {
+	return !SDL_AtomicGet(&g->quit);
+}
 
-	for (size_t i = 0; i < SOUNDS_COUNT; ++ i)
-		Mix_FreeChunk(g->get_sound[i]);
+void game_free_assets(struct game *g) {
+	assets_free(&g->assets);
 
 	SDL_DestroyTexture(g->score_texture.sdl);
-	TTF_CloseFont(g->font);
+	SDL_DestroyTexture(g->score_texture.shadow);
 }
 
 void game_finish(struct game *g) {
 	SDL_Log("--------------------------------");
 
+	SDL_AtomicSet(&g->quit, true);
+	SDL_WaitThread(g->sim_thread, NULL);
+	SDL_Log("Stopped the simulation thread");
+
+	/* Quitting before they were done still has to wait for them */
+	SDL_WaitThread(g->audio_thread, NULL);
+	SDL_WaitThread(g->fonts_thread, NULL);
+
+	for (size_t i = 0; i < g->bots_count; ++ i) {
+		bot_report(&g->bots[i]);
+		bot_unload(&g->bots[i]);
+	}
+	SDL_free(g->bot_paths);
+
+	if (g->bots_count > 0)
+		SDL_Log("Unloaded the bots");
+
+	if (g->logging_telemetry) {
+		telemetry_free(&g->telemetry);
+		SDL_Log("Finished the telemetry log");
+	}
+
+	triple_buffer_free(&g->snapshots);
+	SDL_DestroySemaphore(g->published);
+	SDL_DestroySemaphore(g->consumed);
+	SDL_DestroySemaphore(g->woken);
+	SDL_Log("Destroyed the snapshots");
+
+	rewind_free(&g->rewind);
+	SDL_Log("Destroyed the rewind history");
+
+	if (g->capturing) {
+		capture_free(&g->capture);
+		SDL_Log("Finished the capture");
+	}
+
 	game_free_assets(g);
 	SDL_Log("Destroyed assets");
 
+	render_queue_free(&g->queue);
+	for (size_t i = 0; i < MAP_QUEUES_COUNT; ++ i)
+		render_queue_free(&g->map_queues[i]);
+	SDL_Log("Destroyed the render queues");
+
+	jobs_free(&g->jobs);
+	SDL_Log("Stopped the job workers");
+
+	/* Only once the job workers, the last threads that record into it, are gone */
+	trace_finish();
+
+	if (g->software) {
+		softrast_free(&g->soft);
+		SDL_Log("Destroyed the software rasteriser");
+	}
+
 	SDL_DestroyTexture(g->map);
 	SDL_Log("Destroyed the map texture");
 
@@ -312,7 +655,9 @@ void game_finish(struct game *g) {
 
 	SDL_Log("Finalized");
 
-	Mix_CloseAudio();
+	if (game_audio_ready(g))
+		Mix_CloseAudio();
+
 	TTF_Quit();
 	IMG_Quit();
 	SDL_Quit();
@@ -336,8 +681,8 @@ static void game_render_map_grass(struct game *g) {
 
 			r.x = x * RECT_SIZE;
 
-			SDL_RenderCopy(g->ren, g->get_texture[alt? TEXTURE_GRASS2 :
-			               TEXTURE_GRASS1].sdl, NULL, &r);
+			struct texture *grass = game_texture(g, alt? TEXTURE_GRASS2 : TEXTURE_GRASS1);
+			render_queue_copy(&g->queue, LAYER_GRASS, grass->sdl, &grass->src, &r);
 		}
 	}
 
@@ -354,13 +699,12 @@ static void game_render_map_grass(struct game *g) {
 	h.x += SHADOW_OFFSET * 2;
 	h.w -= SHADOW_OFFSET * 2;
 
-	SDL_SetRenderDrawColor(g->ren, 0, 0, 0, SHADOW_ALPHA);
-	SDL_RenderFillRect(g->ren, &v);
-	SDL_RenderFillRect(g->ren, &h);
+	render_queue_fill(&g->queue, LAYER_GRASS_SHADOW, &v, 0, 0, 0, SHADOW_ALPHA);
+	render_queue_fill(&g->queue, LAYER_GRASS_SHADOW, &h, 0, 0, 0, SHADOW_ALPHA);
 }
 
 static void game_render_screen_fade(struct game *g) {
-	if (!g->darken_screen)
+	if (!g->view->darken_screen)
 		return;
 
 	SDL_Rect r = {
@@ -372,37 +716,33 @@ static void game_render_screen_fade(struct game *g) {
 
 	int a = DARKEN_SCR_ALPHA;
 
-	struct timer *fade_in  = &g->get_timer[TIMER_FADE_IN];
-	struct timer *fade_out = &g->get_timer[TIMER_FADE_OUT];
-
-	if (timer_active(fade_in))
-		a = timer_unit(fade_in, false) * 110;
-	else if (timer_active(fade_out))
-		a = timer_unit(fade_out, true) * 110;
+	if (game_timer_active(g->view, TIMER_FADE_IN))
+		a = game_timer_unit(g->view, TIMER_FADE_IN, false) * 110;
+	else if (game_timer_active(g->view, TIMER_FADE_OUT))
+		a = game_timer_unit(g->view, TIMER_FADE_OUT, true) * 110;
 
-	SDL_SetRenderDrawColor(g->ren, 0, 0, 0, a);
-	SDL_RenderFillRect(g->ren, &r);
+	render_queue_fill(&g->queue, LAYER_UI_FADE, &r, 0, 0, 0, a);
 }
 
 static void game_render_tutorial_ui(struct game *g) {
 	game_render_screen_fade(g);
 
-	struct texture *texture = &g->get_texture[TEXTURE_TUTORIAL];
+	struct texture *texture = game_texture(g, TEXTURE_TUTORIAL);
 	SDL_Rect r = {
 		.x = MAP_W / 2 - texture->w / 2,
-		.y = MAP_H - texture->h * 1.5 - sin((float)g->tick / 10) * 5,
+		.y = MAP_H - texture->h * 1.5 - sin((float)g->view->tick / 10) * 5,
 		.w = texture->w,
 		.h = texture->h,
 	};
 
-	SDL_RenderCopyShadow(g->ren, texture->sdl, NULL, &r, SHADOW_OFFSET, SHADOW_ALPHA);
-	SDL_RenderCopy(g->ren, texture->sdl, NULL, &r);
+	render_queue_copy_shadow(&g->queue, LAYER_UI_SHADOW, texture->shadow, &texture->src, &r, SHADOW_OFFSET);
+	render_queue_copy(&g->queue, LAYER_UI, texture->sdl, &texture->src, &r);
 }
 
 static void game_render_paused_ui(struct game *g) {
 	game_render_screen_fade(g);
 
-		struct texture *texture = &g->get_texture[TEXTURE_PAUSED];
+		struct texture *texture = game_texture(g, TEXTURE_PAUSED);
 		SDL_Rect r = {
 			.x = MAP_W / 2 - texture->w / 2,
 			.y = MAP_H / 2 - texture->h / 2,
@@ -410,17 +750,18 @@ static void game_render_paused_ui(struct game *g) {
 			.h = texture->h,
 		};
 
-		SDL_RenderCopyShadow(g->ren, texture->sdl, NULL, &r, SHADOW_OFFSET, SHADOW_ALPHA);
-		SDL_RenderCopy(g->ren, texture->sdl, NULL, &r);
+		render_queue_copy_shadow(&g->queue, LAYER_UI_SHADOW, texture->shadow, &texture->src, &r,
+		                         SHADOW_OFFSET);
+		render_queue_copy(&g->queue, LAYER_UI, texture->sdl, &texture->src, &r);
 }
 
 static void game_render_dead_ui(struct game *g) {
-	if (!g->darken_screen)
+	if (!g->view->darken_screen)
 		return;
 
 	game_render_screen_fade(g);
 
-	struct texture *texture = &g->get_texture[TEXTURE_YOU_LOST];
+	struct texture *texture = game_texture(g, TEXTURE_YOU_LOST);
 	SDL_Rect r = {
 		.x = MAP_W / 2 - texture->w / 2,
 		.y = texture->h * 2.5,
@@ -428,24 +769,24 @@ static void game_render_dead_ui(struct game *g) {
 		.h = texture->h,
 	};
 
-	float angle = sin((float)g->tick / 20) * 3;
+	float angle = sin((float)g->view->tick / 20) * 3;
 
-	SDL_RenderCopyShadowEx(g->ren, texture->sdl, NULL, &r, angle, NULL, SDL_FLIP_NONE,
-	                       SHADOW_OFFSET, SHADOW_ALPHA);
-	SDL_RenderCopyEx(g->ren, texture->sdl, NULL, &r, angle, NULL, SDL_FLIP_NONE);
+	render_queue_copy_shadow_ex(&g->queue, LAYER_UI_SHADOW, texture->shadow, &texture->src, &r, angle,
+	                            SHADOW_OFFSET);
+	render_queue_copy_ex(&g->queue, LAYER_UI, texture->sdl, &texture->src, &r, angle, SDL_ALPHA_OPAQUE);
 
-	texture = &g->get_texture[TEXTURE_SPACEBAR];
+	texture = game_texture(g, TEXTURE_SPACEBAR);
 	r.x = MAP_W / 2 - texture->w / 2;
-	r.y = MAP_H - texture->h * 2.5 - sin((float)g->tick / 10) * 5;
+	r.y = MAP_H - texture->h * 2.5 - sin((float)g->view->tick / 10) * 5;
 	r.w = texture->w;
 	r.h = texture->h;
 
-	SDL_RenderCopyShadow(g->ren, texture->sdl, NULL, &r, SHADOW_OFFSET, SHADOW_ALPHA);
-	SDL_RenderCopy(g->ren, texture->sdl, NULL, &r);
+	render_queue_copy_shadow(&g->queue, LAYER_UI_SHADOW, texture->shadow, &texture->src, &r, SHADOW_OFFSET);
+	render_queue_copy(&g->queue, LAYER_UI, texture->sdl, &texture->src, &r);
 }
 
 static void game_render_transition_ui(struct game *g) {
-	if (!timer_active(&g->get_timer[TIMER_TRANSITION]))
+	if (!game_timer_active(g->view, TIMER_TRANSITION))
 		return;
 
 	SDL_Rect r = {
@@ -455,14 +796,13 @@ static void game_render_transition_ui(struct game *g) {
 		.h = MAP_H,
 	};
 
-	int a = timer_unit(&g->get_timer[TIMER_TRANSITION], g->state == STATE_DEAD) * 255;
+	int a = game_timer_unit(g->view, TIMER_TRANSITION, g->view->state == STATE_DEAD) * 255;
 
-	SDL_SetRenderDrawColor(g->ren, 10, 10, 10, a);
-	SDL_RenderFillRect(g->ren, &r);
+	render_queue_fill(&g->queue, LAYER_UI_TRANSITION, &r, 10, 10, 10, a);
 }
 
 static void game_render_ui(struct game *g) {
-	switch (g->state) {
+	switch (g->view->state) {
 	case STATE_TUTORIAL: game_render_tutorial_ui(g); break;
 	case STATE_PAUSED:   game_render_paused_ui(g);   break;
 	case STATE_DEAD:     game_render_dead_ui(g);     break;
@@ -472,32 +812,77 @@ static void game_render_ui(struct game *g) {
 	game_render_transition_ui(g);
 }
 
+static void game_render_cheese_job(void *data) {
+	struct game *g = (struct game*)data;
+	cheese_pool_render(&g->view->cheese_pool, g->cheese_texture,
+	                   &g->map_queues[MAP_QUEUE_CHEESE], g->view->ui_clock.now,
+	                   game_quality(g)->effect_draws);
+}
+
+static void game_render_snake_job(void *data) {
+	struct game *g = (struct game*)data;
+	snake_render(&g->view->snake, &g->snake_textures, &g->map_queues[MAP_QUEUE_SNAKE],
+	             g->view->play_clock.now);
+}
+
+static void game_render_particles_job(void *data) {
+	struct game *g = (struct game*)data;
+	particles_render(&g->view->particles, &g->map_queues[MAP_QUEUE_PARTICLES], LAYER_PARTICLES,
+	                 g->view->play_clock.now, game_quality(g)->effect_draws);
+}
+
 static void game_render_map(struct game *g) {
+	Uint64 start = trace_begin();
+
+	g->cheese_texture = game_texture(g, TEXTURE_CHEESE);
+	g->snake_textures = (struct snake_textures){
+		.eyes      = game_texture(g, TEXTURE_EYES),
+		.eyes_dead = game_texture(g, TEXTURE_EYES_DEAD),
+		.tongue    = game_texture(g, TEXTURE_TONGUE),
+	};
+
+	static job_fn map_jobs[MAP_QUEUES_COUNT] = {
+		[MAP_QUEUE_CHEESE]    = game_render_cheese_job,
+		[MAP_QUEUE_SNAKE]     = game_render_snake_job,
+		[MAP_QUEUE_PARTICLES] = game_render_particles_job,
+	};
+
+	struct job *jobs[MAP_QUEUES_COUNT];
+	for (size_t i = 0; i < MAP_QUEUES_COUNT; ++ i) {
+		jobs[i] = jobs_create(&g->jobs, map_jobs[i], g);
+		jobs_submit(&g->jobs, jobs[i]);
+	}
+
+	/* The grass goes straight into the queue in the meantime */
 	game_render_map_grass(g);
-	cheese_pool_render(&g->cheese_pool, g->get_texture[TEXTURE_CHEESE].sdl, g->ren);
-	snake_render(&g->snake, g->ren);
-	particles_render(&g->particles, g->ren);
+
+	for (size_t i = 0; i < MAP_QUEUES_COUNT; ++ i) {
+		jobs_wait(&g->jobs, jobs[i]);
+		render_queue_append(&g->queue, &g->map_queues[i]);
+	}
+
+	trace_end("game_render_map", start);
 }
 
 static void game_fade_out(struct game *g) {
-	g->darken_screen = true;
-	timer_start(&g->get_timer[TIMER_FADE_OUT]);
+	g->sim.darken_screen = true;
+	game_timer_start(g, TIMER_FADE_OUT);
 }
 
 static void game_fade_in(struct game *g) {
-	timer_start(&g->get_timer[TIMER_FADE_IN]);
+	game_timer_start(g, TIMER_FADE_IN);
 }
 
 static void game_render_create_score_texture(struct game *g) {
 	char text[16] = {0};
-	snprintf(text, sizeof(text), "%zu", g->score);
+	snprintf(text, sizeof(text), "%zu", g->view->score);
 	SDL_Color color = {
 		.r = 255,
 		.g = 255,
 		.b = 255,
 		.a = 200,
 	};
-	SDL_Surface *surface = TTF_RenderText_Solid(g->font, text, color);
+	SDL_Surface *surface = TTF_RenderText_Solid(g->assets.font, text, color);
 	if (surface == NULL) {
 		SDL_Log("%s", SDL_GetError());
 		exit(EXIT_FAILURE);
@@ -509,6 +894,12 @@ static void game_render_create_score_texture(struct game *g) {
 		exit(EXIT_FAILURE);
 	}
 
+	g->score_texture.shadow = SDL_CreateShadowTextureFromSurface(g->ren, surface, SHADOW_ALPHA);
+	if (g->score_texture.shadow == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
 	g->score_texture.w = surface->w;
 	g->score_texture.h = surface->h;
 
@@ -516,42 +907,115 @@ static void game_render_create_score_texture(struct game *g) {
 }
 
 static void game_render_score(struct game *g) {
-	struct texture *texture = &g->get_texture[TEXTURE_CHEESE];
+	struct texture *texture = game_texture(g, TEXTURE_CHEESE);
 	SDL_Rect r = {
 		.x = PADDING,
 		.y = PADDING,
 		.w = texture->w,
 		.h = texture->h,
 	};
-	SDL_RenderCopyShadow(g->ren, texture->sdl, NULL, &r, SHADOW_OFFSET / 1.5, SHADOW_ALPHA);
-	SDL_SetTextureAlphaMod(texture->sdl, 220);
-	SDL_RenderCopy(g->ren, texture->sdl, NULL, &r);
-	SDL_SetTextureAlphaMod(texture->sdl, 255);
+	render_queue_copy_shadow(&g->queue, LAYER_UI_SHADOW, texture->shadow, &texture->src, &r,
+	                         SHADOW_OFFSET / 1.5);
+	render_queue_copy_ex(&g->queue, LAYER_UI, texture->sdl, &texture->src, &r, 0, 220);
 
-	if (g->prev_score != g->score || g->score_texture.sdl == NULL) {
+	/* The number shows up once the font is loaded, and not at all if it could not be */
+	if (!SDL_AtomicGet(&g->fonts_ready))
+		return;
+
+	if (g->rendered_score != g->view->score || g->score_texture.sdl == NULL) {
 		SDL_DestroyTexture(g->score_texture.sdl);
+		SDL_DestroyTexture(g->score_texture.shadow);
 		game_render_create_score_texture(g);
+
+		g->rendered_score = g->view->score;
 	}
 
 	r.x += r.w + 10;
 	r.y -= 2;
 	r.w  = g->score_texture.w / 2;
 	r.h  = g->score_texture.h / 2;
-	SDL_RenderCopyShadow(g->ren, g->score_texture.sdl, NULL, &r, SHADOW_OFFSET / 1.5, SHADOW_ALPHA);
-	SDL_RenderCopy(g->ren, g->score_texture.sdl, NULL, &r);
+	render_queue_copy_shadow(&g->queue, LAYER_UI_SHADOW, g->score_texture.shadow, NULL, &r,
+	                         SHADOW_OFFSET / 1.5);
+	render_queue_copy(&g->queue, LAYER_UI, g->score_texture.sdl, NULL, &r);
+}
+
+static const uint32_t shadow_layers = 1 << LAYER_GRASS_SHADOW | 1 << LAYER_CHEESE_SHADOW |
+                                      1 << LAYER_SNAKE_SHADOW | 1 << LAYER_UI_SHADOW;
+
+/* Filtering belongs to the textures, so it only changes along with the level. The hint is for
+ * whatever gets created later on. */
+static void game_set_scale_mode(struct game *g) {
+	bool          linear = game_quality(g)->linear;
+	SDL_ScaleMode mode   = linear? SDL_ScaleModeLinear : SDL_ScaleModeNearest;
+
+	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, linear? "linear" : "nearest");
+
+	SDL_Texture *textures[] = {g->assets.atlas.sdl, g->assets.atlas.shadow, g->map};
+	for (size_t i = 0; i < SDL_arraysize(textures); ++ i) {
+		if (textures[i] != NULL)
+			SDL_SetTextureScaleMode(textures[i], mode);
+	}
+}
+
+static void game_set_quality(struct game *g) {
+	uint32_t skip = game_quality(g)->shadows? 0 : shadow_layers;
+
+	render_queue_skip_layers(&g->queue, skip);
+	for (size_t i = 0; i < MAP_QUEUES_COUNT; ++ i)
+		render_queue_skip_layers(&g->map_queues[i], skip);
 }
 
 void game_render(struct game *g) {
+	/* There is nothing new to draw until the simulation publishes its next tick */
+	SDL_SemWaitTimeout(g->published, 1000 / TICK_RATE * 2);
+
+	bool fresh;
+	g->view = (struct game_state*)triple_buffer_read(&g->snapshots, &fresh);
+	if (!fresh)
+		return;
+
+	g->idle = game_idle(g, g->view);
+
+	/* A hidden window has nothing to show the frame in, so there is no point drawing it */
+	if (g->hidden && !g->lockstep) {
+		g->last_frame = 0;
+		return;
+	}
+
+	/* Waiting on the simulation and on vsync is not part of what quality can make faster */
+	Uint64 work_start = SDL_GetPerformanceCounter();
+	game_set_quality(g);
+
+	if (g->rendered_state != g->view->state) {
+		g->rendered_state = g->view->state;
+		assets_prefetch(&g->assets, state_prefetch_textures[g->view->state], 0);
+	}
+
+	if (g->capturing) {
+		g->screen = capture_target(&g->capture);
+		SDL_SetRenderTarget(g->ren, g->screen);
+	}
+
 	SDL_SetRenderDrawColor(g->ren, BG_COLOR_EXPAND, SDL_ALPHA_OPAQUE);
 	SDL_RenderClear(g->ren);
 
 	SDL_RenderSetViewport(g->ren, NULL);
 
 	game_render_score(g);
-
-	SDL_SetRenderTarget(g->ren, g->map);
-	game_render_map(g);
-	SDL_SetRenderTarget(g->ren, NULL);
+	render_queue_flush(&g->queue);
+
+	if (g->software) {
+		render_queue_set_target(&g->queue, &g->soft);
+		game_render_map(g);
+		render_queue_set_target(&g->queue, NULL);
+
+		softrast_upload(&g->soft, g->map);
+	} else {
+		SDL_SetRenderTarget(g->ren, g->map);
+		game_render_map(g);
+		render_queue_flush(&g->queue);
+		SDL_SetRenderTarget(g->ren, g->screen);
+	}
 
 	SDL_RenderSetViewport(g->ren, &g->map_rect);
 	SDL_Rect back = {
@@ -564,242 +1028,555 @@ void game_render(struct game *g) {
 	SDL_RenderFillRect(g->ren, &back);
 
 	SDL_Rect r = back;
-	r.x = g->map_shake_pos.x;
-	r.x = g->map_shake_pos.x;
+	r.x = g->view->map_shake_pos.x;
+	r.x = g->view->map_shake_pos.x;
 	SDL_RenderCopy(g->ren, g->map, NULL, &r);
 
 	game_render_ui(g);
+	render_queue_flush(&g->queue);
 	SDL_RenderSetViewport(g->ren, NULL);
 
-	SDL_RenderPresent(g->ren);
+	if (g->lockstep)
+		SDL_SemPost(g->consumed);
+
+	if (g->capturing) {
+		capture_frame(&g->capture);
+		if (!g->headless)
+			SDL_RenderCopy(g->ren, g->screen, NULL, NULL);
+
+		if (g->capture_limit != 0 && g->capture.drawn >= g->capture_limit)
+			SDL_AtomicSet(&g->quit, true);
+	}
+
+	g->render_us = (SDL_GetPerformanceCounter() - work_start) * 1000000 /
+	               SDL_GetPerformanceFrequency();
+	if (g->governed && quality_frame(&g->quality, g->render_us))
+		game_set_scale_mode(g);
+
+	if (!g->headless) {
+		Uint64 start = trace_begin();
+		SDL_RenderPresent(g->ren);
+		trace_end("SDL_RenderPresent", start);
+	}
+
+	if (!g->presented) {
+		g->presented = true;
+		SDL_Log("Presented the first frame after %.1f ms", game_ms_since_start(g));
+	}
+
+	g->render_stats = render_queue_take_stats(&g->queue);
+
+	/* Timed from one presented frame to the next, leaving out the frames that were slow on purpose */
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (g->logging_telemetry && g->last_frame != 0 && !g->idle) {
+		uint32_t us = (now - g->last_frame) * 1000000 / SDL_GetPerformanceFrequency();
+
+		struct telemetry_record summary;
+		if (frame_times_add(&g->frame_times, us, &summary)) {
+			summary.tick = g->view->tick;
+			telemetry_log(&g->telemetry, TELEMETRY_RENDER, &summary);
+		}
+	}
+	g->last_frame = now;
+#ifdef CNAKE_DEBUG
+	if (g->view->tick % 300 == 0)
+		SDL_Log("Rendered %zu commands in %zu draw calls with %zu state changes",
+		        g->render_stats.cmds, g->render_stats.draw_calls, g->render_stats.state_changes);
+#endif
 }
 
-static void game_snake_change_dir(struct game *g, enum dir dir) {
-	if (g->state == STATE_TUTORIAL && !timer_active(&g->get_timer[TIMER_FADE_IN])) {
+static void game_snake_change_dir(struct game *g, enum dir dir, Uint32 timestamp) {
+	if (g->sim.state == STATE_TUTORIAL && !game_timer_active(&g->sim, TIMER_FADE_IN)) {
 		if (rand_irange(0, 10) == 0)
-			Mix_PlayChannel(1, g->get_sound[SOUND_CHEESEBURGER], 0);
+			game_play_sound(g, SOUND_CHEESEBURGER);
 
 		game_fade_in(g);
-	} else if (g->state == STATE_GAMEPLAY)
-		snake_change_dir(&g->snake, dir);
+	} else if (g->sim.state == STATE_GAMEPLAY)
+		snake_change_dir(&g->sim.snake, dir, timestamp);
+}
+
+static void game_handle_window_event(struct game *g) {
+	switch (g->evt.window.event) {
+	case SDL_WINDOWEVENT_HIDDEN:
+	case SDL_WINDOWEVENT_MINIMIZED: g->hidden = true; break;
+
+	case SDL_WINDOWEVENT_SHOWN:
+	case SDL_WINDOWEVENT_EXPOSED:
+	case SDL_WINDOWEVENT_RESTORED: g->hidden = false; break;
+
+	default: break;
+	}
+}
+
+static void game_handle_event(struct game *g) {
+	switch (g->evt.type) {
+	case SDL_QUIT:        SDL_AtomicSet(&g->quit, true); break;
+	case SDL_WINDOWEVENT: game_handle_window_event(g);   break;
+	case SDL_KEYDOWN: {
+		if (g->evt.key.keysym.sym == SDLK_ESCAPE) {
+			SDL_AtomicSet(&g->quit, true);
+			break;
+		}
+
+		struct input in = {
+			.key       = g->evt.key.keysym.sym,
+			.timestamp = g->evt.key.timestamp,
+		};
+
+		if (!input_queue_push(&g->input, in))
+			SDL_Log("Input queue is full, dropped a key press");
+
+		if (SDL_SemValue(g->woken) == 0)
+			SDL_SemPost(g->woken);
+	} break;
+
+	default: break;
+	}
 }
 
 void game_handle_events(struct game *g) {
-	while (SDL_PollEvent(&g->evt)) {
-		switch (g->evt.type) {
-		case SDL_QUIT: g->state = STATE_QUIT; break;
-		case SDL_KEYDOWN:
-			switch (g->evt.key.keysym.sym) {
-			case SDLK_ESCAPE: g->state = STATE_QUIT; break;
-
-			case SDLK_w: game_snake_change_dir(g, UP);    break;
-			case SDLK_a: game_snake_change_dir(g, LEFT);  break;
-			case SDLK_s: game_snake_change_dir(g, DOWN);  break;
-			case SDLK_d: game_snake_change_dir(g, RIGHT); break;
+	/* While idle or hidden, sleep until there is input or the next frame is due, instead of
+	 * waking up for every tick */
+	if ((g->idle || g->hidden) &&
+	    SDL_WaitEventTimeout(&g->evt, IDLE_FRAME_TICKS * 1000 / TICK_RATE))
+		game_handle_event(g);
+
+	while (SDL_PollEvent(&g->evt))
+		game_handle_event(g);
+}
 
-#ifdef CNAKE_DEBUG
-			case SDLK_r: snake_shrink_to(&g->snake, 1); break;
-			case SDLK_e: snake_grow(&g->snake);         break;
+static void game_rewind(struct game *g) {
+	size_t tick = g->sim.tick > REWIND_STEP? g->sim.tick - REWIND_STEP : 0;
 
-			case SDLK_q: timer_start(&g->get_timer[TIMER_SCR_SHAKE]); break;
-#endif
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t restored;
+	bool   ok = rewind_restore(&g->rewind, tick, &g->sim, &restored);
+	Uint64 end = SDL_GetPerformanceCounter();
 
-			case SDLK_SPACE: {
-				bool fading = timer_active(&g->get_timer[TIMER_FADE_IN]) ||
-				              timer_active(&g->get_timer[TIMER_FADE_OUT]);
+	if (ok)
+		SDL_Log("Rewound to tick %zu in %.1f us", restored,
+		        (double)(end - start) * 1000000 / SDL_GetPerformanceFrequency());
+	else
+		SDL_Log("Nothing to rewind to");
+}
 
-				if (g->state == STATE_DEAD && !fading && g->darken_screen)
-					timer_start(&g->get_timer[TIMER_TRANSITION]);
-				else if (g->state == STATE_PAUSED && !fading)
-					game_fade_in(g);
-				else if (g->state == STATE_GAMEPLAY && !fading) {
-					g->state = STATE_PAUSED;
-					game_fade_out(g);
-				}
+static void game_save(struct game *g) {
+	if (savefile_write(g->save_path, &g->sim, sizeof(g->sim)))
+		SDL_Log("Saved the game to '%s'", g->save_path);
+}
 
-			} break;
+/* A save comes from outside the game, so everything in it that indexes into something else is
+ * checked before it replaces the running game */
+static bool game_state_valid(void *data) {
+	struct game_state *s = (struct game_state*)data;
 
-			default: break;
-			}
+	if ((unsigned)s->state > STATE_DEAD || !snake_valid(&s->snake) ||
+	    !cheese_pool_valid(&s->cheese_pool))
+		return false;
 
-		default: break;
-		}
+	if (!timer_wheel_valid(&s->ui_clock) || !timer_wheel_valid(&s->play_clock))
+		return false;
+
+	struct timer *tongue = &s->snake.tongue_timer;
+	if (tongue->event != TIMER_SNAKE_TONGUE || !timer_valid(tongue, &s->play_clock))
+		return false;
+
+	for (int i = 0; i < TIMERS_COUNT; ++ i) {
+		struct timer *t = &s->get_timer[i];
+		if (t->event != i || t->time != timer_times[i] || !timer_valid(t, game_timer_clock(s, i)))
+			return false;
 	}
+
+	return true;
 }
 
-static void game_emit_snake_particles_at(struct game *g, int x, int y, size_t count) {
-	for (size_t i = 0; i < PARTICLES_CAPACITY && count > 0; ++ i) {
-		if (particle_active(&g->particles.get[i]))
-			continue;
+static void game_load(struct game *g) {
+	if (!savefile_read(g->save_path, &g->sim, sizeof(g->sim), game_state_valid))
+		return;
 
-		-- count;
+	/* The history leads up to the game that was just replaced */
+	rewind_reset(&g->rewind);
+	SDL_Log("Loaded the game from '%s'", g->save_path);
+}
 
-		float  vel   = rand_frange(PARTICLE_MIN_VEL, PARTICLE_MAX_VEL, 2);
-		float  angle = rand_irange(0, 360 - 1);
-		size_t time  = rand_irange(PARTICLE_MIN_TIME, PARTICLE_MAX_TIME);
-		int    size  = rand_irange(PARTICLE_MIN_SIZE, PARTICLE_MAX_SIZE);
+static void game_handle_key(struct game *g, struct input *in) {
+	switch (in->key) {
+	case SDLK_w: game_snake_change_dir(g, UP,    in->timestamp); break;
+	case SDLK_a: game_snake_change_dir(g, LEFT,  in->timestamp); break;
+	case SDLK_s: game_snake_change_dir(g, DOWN,  in->timestamp); break;
+	case SDLK_d: game_snake_change_dir(g, RIGHT, in->timestamp); break;
 
-		SDL_Rect dims = {
-			.x = rand_irange(x * RECT_SIZE, (x + 1) * RECT_SIZE),
-			.y = rand_irange(y * RECT_SIZE, (y + 1) * RECT_SIZE),
-			.w = size,
-			.h = size,
-		};
+#ifdef CNAKE_DEBUG
+	case SDLK_r: snake_shrink_to(&g->sim.snake, 1); break;
+	case SDLK_e: snake_grow(&g->sim.snake);         break;
+
+	case SDLK_q: game_timer_start(g, TIMER_SCR_SHAKE); break;
+#endif
+
+	case SDLK_BACKSPACE: game_rewind(g); break;
 
-		particle_start(&g->particles.get[i], vel, 0.95, angle, time,
-		               dims, SNAKE_PARTICLE_COLOR_EXPAND);
+	case SDLK_F5: game_save(g); break;
+	case SDLK_F9: game_load(g); break;
+
+	case SDLK_SPACE: {
+		bool fading = game_timer_active(&g->sim, TIMER_FADE_IN) ||
+		              game_timer_active(&g->sim, TIMER_FADE_OUT);
+
+		if (g->sim.state == STATE_DEAD && !fading && g->sim.darken_screen)
+			game_timer_start(g, TIMER_TRANSITION);
+		else if (g->sim.state == STATE_PAUSED && !fading)
+			game_fade_in(g);
+		else if (g->sim.state == STATE_GAMEPLAY && !fading) {
+			game_set_state(g, STATE_PAUSED);
+			game_fade_out(g);
+		}
+
+	} break;
+
+	default: break;
 	}
 }
 
 #define MAX_RETRIES 10
 
+static bool game_cell_free(struct game *g, int x, int y) {
+	SDL_Point at = { .x = x, .y = y };
+	return cheese_pool_find(&g->sim.cheese_pool, x, y) == NULL &&
+	       snake_find(&g->sim.snake, at, 0) >= g->sim.snake.len;
+}
+
+/* Random guesses are cheap and almost always hit on a board that is mostly empty. Once they keep
+ * missing, one of the free cells is picked out of all of them, so that the last free cells of an
+ * almost full board still get their cheese. */
 static bool game_get_new_cheese_pos(struct game *g, SDL_Point *ret) {
 	for (int i = 0; i < MAX_RETRIES; ++ i) {
 		int x = rand_irange(0, COLS - 1);
 		int y = rand_irange(0, ROWS - 1);
 
-		for (size_t i = 0; i < CHEESE_CAPACITY; ++ i) {
-			struct cheese *c = &g->cheese_pool.get[i];
-			if (c->spawned && c->at.x == x && c->at.y == y)
-				goto retry;
+		if (game_cell_free(g, x, y)) {
+			ret->x = x;
+			ret->y = y;
+			return true;
 		}
+	}
 
-		for (size_t i = 0; i < g->snake.len; ++ i) {
-			if (g->snake.body[i].x == x && g->snake.body[i].y == y)
-				goto retry;
+	bool empty[ROWS][COLS];
+	int  count = 0;
+	for (int y = 0; y < ROWS; ++ y) {
+		for (int x = 0; x < COLS; ++ x) {
+			empty[y][x] = game_cell_free(g, x, y);
+			count      += empty[y][x];
 		}
+	}
 
-		ret->x = x;
-		ret->y = y;
-		return true;
+	if (count == 0)
+		return false;
 
-	retry:
-		continue;
+	int pick = rand_irange(0, count - 1);
+	for (int y = 0; y < ROWS; ++ y) {
+		for (int x = 0; x < COLS; ++ x) {
+			if (empty[y][x] && pick -- == 0) {
+				ret->x = x;
+				ret->y = y;
+				return true;
+			}
+		}
 	}
 
-	SDL_Log("Failed to get new cheese position after %i retries", MAX_RETRIES);
+	UNREACHABLE("Lost count of the free cells");
 	return false;
 }
 
 static void game_update_scr_shake(struct game *g) {
-	struct timer *shake = &g->get_timer[TIMER_SCR_SHAKE];
-
-	int shake_size = timer_unit(shake, false) * SCR_SHAKE_INTENSITY;
+	int shake_size = game_timer_unit(&g->sim, TIMER_SCR_SHAKE, false) * SCR_SHAKE_INTENSITY *
+	                 game_quality(g)->shake;
 	if (shake_size > 0) {
-		g->map_shake_pos.x = shake_size / 2 - rand() % shake_size;
-		g->map_shake_pos.y = shake_size / 2 - rand() % shake_size;
-	} else if (timer_just_ended(shake)) {
-		g->map_shake_pos.x = 0;
-		g->map_shake_pos.y = 0;
+		g->sim.map_shake_pos.x = shake_size / 2 - rand() % shake_size;
+		g->sim.map_shake_pos.y = shake_size / 2 - rand() % shake_size;
 	}
 }
 
 static bool game_spawn_cheese(struct game *g) {
-	size_t i;
-	for (i = 0; i < CHEESE_CAPACITY; ++ i) {
-		if (!g->cheese_pool.get[i].spawned)
-			break;
+	SDL_Point pos;
+	if (!game_get_new_cheese_pos(g, &pos))
+		return false;
+
+	return cheese_pool_spawn(&g->sim.cheese_pool, pos.x, pos.y) != NULL;
+}
+
+static SDL_Keycode dir_keys[] = {
+	[UP]    = SDLK_w,
+	[LEFT]  = SDLK_a,
+	[DOWN]  = SDLK_s,
+	[RIGHT] = SDLK_d,
+};
+
+/* Plays for the AI or a bot, starting every game and restarting it after every death on its own.
+ * The turns are taken in game_autoplay_turn instead. */
+static void game_autoplay(struct game *g) {
+	struct input in = {.timestamp = SDL_GetTicks()};
+
+	switch (g->sim.state) {
+	case STATE_TUTORIAL: in.key = dir_keys[RIGHT]; break;
+	case STATE_DEAD:
+		if (game_timer_active(&g->sim, TIMER_TRANSITION))
+			return;
+
+		in.key = SDLK_SPACE;
+		break;
+
+	default: return;
 	}
 
-	if (i >= CHEESE_CAPACITY)
-		UNREACHABLE("Cannot spawn any more cheese");
+	game_handle_key(g, &in);
+}
+
+/* The planner thinks on every step the snake spends in a cell, and only turns right before it
+ * leaves it */
+static bool game_ai_dir(struct game *g, float by, Uint64 budget_us, enum dir *dir) {
+	struct snake *s = &g->sim.snake;
+	if (s->turns_count > 0)
+		return false;
 
-	bool success = game_get_new_cheese_pos(g, &g->cheese_pool.get[i].at);
-	if (success)
-		g->cheese_pool.get[i].spawned = true;
+	/* The cycle has nothing to think about until the snake is about to move */
+	if (g->hamilton) {
+		if (!snake_will_move(s, by))
+			return false;
+
+		*dir = hamilton_dir(&g->cycle, s, &g->sim.cheese_pool);
+		return true;
+	}
 
-	return success;
+	planner_think(&g->planner, s, &g->sim.cheese_pool, budget_us);
+
+#ifdef CNAKE_DEBUG
+	if (g->sim.tick % TICK_RATE == 0) {
+		SDL_Log("The AI ran %zu rollouts in the last second", g->planner.rollouts);
+		g->planner.rollouts = 0;
+	}
+#endif
+
+	if (!snake_will_move(s, by))
+		return false;
+
+	*dir = planner_best(&g->planner);
+	return true;
 }
 
-static void game_update_gameplay(struct game *g) {
-	SDL_Point *head = g->snake.head;
+/* A bot is only asked on the steps that move the snake, and not at all once the tick used up the
+ * time it has for the bots */
+static bool game_bot_dir(struct game *g, float by, Uint64 until, enum dir *dir) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (!snake_will_move(&g->sim.snake, by) || now >= until)
+		return false;
+
+	Uint64 freq       = SDL_GetPerformanceFrequency();
+	Uint32 timeout_ms = ((until - now) * 1000 + freq - 1) / freq;
+	return bot_think(&g->bots[g->bot], &g->sim.snake, &g->sim.cheese_pool, g->sim.tick,
+	                 g->sim.score, timeout_ms, dir);
+}
 
-	int prev_head_x = head->x;
-	int prev_head_y = head->y;
+/* Asked before every step, so that the AI or a bot gets to turn on every cell however many of
+ * them the snake crosses on one tick */
+static void game_autoplay_turn(struct game *g, float by, size_t steps, Uint64 bots_until) {
+	Uint64   start = SDL_GetPerformanceCounter();
+	enum dir dir;
+	bool     turn = g->bots_count > 0? game_bot_dir(g, by, bots_until, &dir) :
+	                                   game_ai_dir(g, by, AI_BUDGET_US / steps, &dir);
+	g->sim.think_us += game_us_since(start);
+	if (!turn || dir == snake_next_dir(&g->sim.snake))
+		return;
 
-	struct cheese *cheese = NULL;
-	for (size_t i = 0; i < CHEESE_CAPACITY; ++ i) {
-		struct cheese *c = &g->cheese_pool.get[i];
-		if (c->spawned && c->at.x == prev_head_x && c->at.y == prev_head_y) {
-			if (g->snake.offset == 0)
-				Mix_PlayChannel(1, g->get_sound[SOUND_EAT], 0);
+	struct input in = {
+		.key       = dir_keys[dir],
+		.timestamp = SDL_GetTicks(),
+	};
+	game_handle_key(g, &in);
+}
 
-			if (g->tick % 1 == 0)
-				cheese_bite(c);
+/* The step itself is left to snake_step, this only adds everything around it that the player
+ * sees and hears. A step never goes further than into the next cell. */
+static void game_update_gameplay_step(struct game *g, float by) {
+	struct snake *snake = &g->sim.snake;
 
-			cheese = c;
-			break;
-		}
+	size_t         cheese = CHEESE_NONE;
+	SDL_Point      head   = snake_head(snake);
+	struct cheese *c      = cheese_pool_find(&g->sim.cheese_pool, head.x, head.y);
+	if (c != NULL) {
+		if (g->sim.tick % 1 == 0)
+			cheese_bite(c, &g->sim.cheese_pool.particles,
+			            game_particles_count(g, PARTICLES_ON_BITE), g->sim.ui_clock.now);
+
+		cheese = c->handle;
 	}
 
-	if (snake_move(&g->snake, SNAKE_SPEED)) {
-		if (cheese != NULL) {
-			cheese_eat(cheese);
-			snake_grow(&g->snake);
-			++ g->score;
-		}
+	struct snake_step step;
+	snake_step(snake, by, cheese != CHEESE_NONE, &step);
+
+#ifdef CNAKE_DEBUG
+	if (step.moved && snake->turned_at != 0)
+		SDL_Log("Turned %u ms after the key press", SDL_GetTicks() - snake->turned_at);
+#endif
+
+	head = snake_head(snake);
+	if (step.moved && cheese_pool_find(&g->sim.cheese_pool, head.x, head.y) != NULL)
+		game_play_sound(g, SOUND_EAT);
+
+	if (step.ate) {
+		cheese_pool_eat(&g->sim.cheese_pool, cheese);
+		++ g->sim.score;
+
+		game_telemetry(g, TELEMETRY_CHEESE, snake->len, g->sim.score);
 	}
 
-	for (size_t i = 1; i < g->snake.len; ++ i) {
-		if (g->snake.body[i].x == head->x && g->snake.body[i].y == head->y) {
-			game_emit_snake_particles_at(g, g->snake.body[i].x, g->snake.body[i].y,
-			                             PARTICLES_ON_SHRINK);
-			timer_start(&g->get_timer[TIMER_SCR_SHAKE]);
+	if (step.bit_at > 0) {
+		game_emit_snake_particles_at(g, step.bite.x, step.bite.y,
+		                             game_particles_count(g, PARTICLES_ON_SHRINK));
+		game_timer_start(g, TIMER_SCR_SHAKE);
 
-			Mix_PlayChannel(1, g->get_sound[SOUND_HIT], 0);
-			snake_shrink_to(&g->snake, i);
-			break;
-		}
+		game_play_sound(g, SOUND_HIT);
+		game_telemetry(g, TELEMETRY_BITE, snake->len, g->sim.score);
 	}
 
-	if (head->x < 0 || head->x >= COLS || head->y < 0 || head->y >= ROWS) {
-		game_emit_snake_particles_at(g, prev_head_x, prev_head_y, PARTICLES_ON_SHRINK);
-		timer_start(&g->get_timer[TIMER_SCR_SHAKE]);
+	if (step.died) {
+		game_emit_snake_particles_at(g, step.from.x, step.from.y,
+		                             game_particles_count(g, PARTICLES_ON_SHRINK));
+		game_timer_start(g, TIMER_SCR_SHAKE);
+
+		game_play_sound(g, SOUND_DEATH);
+		game_set_state(g, STATE_DEAD);
+		game_timer_start(g, TIMER_DEAD);
+
+		game_telemetry(g, TELEMETRY_DEATH, g->sim.snake.len, g->sim.score);
 
-		Mix_PlayChannel(1, g->get_sound[SOUND_DEATH], 0);
-		g->snake.dead = true;
-		g->state = STATE_DEAD;
-		timer_start(&g->get_timer[TIMER_DEAD]);
+		if (g->bots_count > 0)
+			bot_game_over(&g->bots[g->bot], g->sim.score);
 	}
+}
+
+/* How far the snake goes on every tick, in cells */
+static float game_snake_speed(struct game *g) {
+	return SNAKE_SPEED * g->speed;
+}
+
+/* However fast the snake goes, every cell it crosses on the way is stepped through on its own and
+ * in order, so that it never skips past a cheese, its own body or a wall */
+static void game_update_gameplay(struct game *g) {
+	float left = game_snake_speed(g);
+
+	/* The time the AI and the bots get to think is for the whole tick, not for every step of it */
+	size_t steps      = ceilf(left);
+	Uint64 bots_until = SDL_GetPerformanceCounter() +
+	                    BOT_DEADLINE_MS * SDL_GetPerformanceFrequency() / 1000;
 
-	if (g->tick % CHEESE_SPAWN_TICK_DELAY == 0)
+	while (left > 0 && g->sim.state == STATE_GAMEPLAY) {
+		float by = left < 1? left : 1;
+		if (g->ai || g->bots_count > 0)
+			game_autoplay_turn(g, by, steps, bots_until);
+
+		game_update_gameplay_step(g, by);
+		left -= by;
+	}
+
+	if (g->sim.tick % CHEESE_SPAWN_TICK_DELAY == 0) {
+		Uint64 start = SDL_GetPerformanceCounter();
 		game_spawn_cheese(g);
+		g->sim.spawn_us = game_us_since(start);
+	}
+
+	if (g->sim.tick % TELEMETRY_SAMPLE_TICKS == 0)
+		game_telemetry(g, TELEMETRY_SAMPLE, g->sim.snake.len, g->sim.score);
 }
 
-void game_update(struct game *g) {
-	++ g->tick;
-	g->prev_score = g->score;
+static void game_handle_timer(struct game *g, int timer) {
+	switch (timer) {
+	case TIMER_SCR_SHAKE:
+		g->sim.map_shake_pos.x = 0;
+		g->sim.map_shake_pos.y = 0;
 
-	for (size_t i = 0; i < TIMERS_COUNT; ++ i) {
-		if (i == TIMER_SCR_SHAKE)
-			continue;
+		break;
+
+	case TIMER_FADE_IN:
+		g->sim.darken_screen = false;
+		game_set_state(g, STATE_GAMEPLAY);
+
+		break;
+
+	case TIMER_DEAD: game_fade_out(g); break;
+	case TIMER_TRANSITION:
+		if (g->sim.state == STATE_DEAD) {
+			game_restart(g);
+			game_timer_start(g, TIMER_TRANSITION);
+		}
+
+		break;
 
-		timer_update(&g->get_timer[i]);
+	case TIMER_SNAKE_TONGUE: snake_update_tongue(&g->sim.snake, &g->sim.play_clock); break;
+
+	default: break;
 	}
+}
 
-	cheese_pool_update(&g->cheese_pool);
+static void game_update_cheese_job(void *data) {
+	struct game *g = (struct game*)data;
+	cheese_pool_update(&g->sim.cheese_pool, g->sim.ui_clock.now);
+}
 
-	if (g->state == STATE_GAMEPLAY || g->state == STATE_DEAD) {
-		timer_update(&g->get_timer[TIMER_SCR_SHAKE]);
-		particles_update(&g->particles);
-		snake_update(&g->snake);
+static void game_update_particles_range(void *data, size_t start, size_t end) {
+	struct game *g = (struct game*)data;
+	particles_update_range(&g->sim.particles, g->sim.play_clock.now, start, end);
+}
 
-		if (g->state != STATE_DEAD)
+void game_update(struct game *g) {
+	Uint64 update_start = SDL_GetPerformanceCounter();
+	g->sim.think_us = 0;
+	g->sim.spawn_us = 0;
+
+	struct input in;
+	while (input_queue_pop(&g->input, &in))
+		game_handle_key(g, &in);
+
+	if (g->ai || g->bots_count > 0)
+		game_autoplay(g);
+
+	++ g->sim.tick;
+
+	/* Timers cost nothing until they fire, everything that does fire is handled below */
+	timer_wheel_advance(&g->sim.ui_clock);
+
+	/* Both particle pools are updated on the workers, and only the gameplay touches them after */
+	struct job *cheese = jobs_create(&g->jobs, game_update_cheese_job, g);
+	jobs_submit(&g->jobs, cheese);
+
+	bool        playing   = g->sim.state == STATE_GAMEPLAY || g->sim.state == STATE_DEAD;
+	struct job *particles = NULL;
+	if (playing) {
+		timer_wheel_advance(&g->sim.play_clock);
+		particles = jobs_parallel_for(&g->jobs, PARTICLES_CAPACITY, PARTICLES_JOB_GRAIN,
+		                              game_update_particles_range, g);
+	}
+
+	jobs_wait(&g->jobs, cheese);
+	if (particles != NULL)
+		jobs_wait(&g->jobs, particles);
+
+	if (playing) {
+		if (g->sim.state != STATE_DEAD) {
+			Uint64 start = trace_begin();
 			game_update_gameplay(g);
+			trace_end("game_update_gameplay", start);
+		}
 
 		game_update_scr_shake(g);
 	}
 
-	if (timer_just_ended(&g->get_timer[TIMER_FADE_IN])) {
-		g->darken_screen = false;
-		g->state         = STATE_GAMEPLAY;
-	}
+	int timer;
+	while (timer_wheel_poll(&g->sim.ui_clock, &timer))
+		game_handle_timer(g, timer);
 
-	if (timer_just_ended(&g->get_timer[TIMER_DEAD]))
-		game_fade_out(g);
+	while (timer_wheel_poll(&g->sim.play_clock, &timer))
+		game_handle_timer(g, timer);
 
-	if (timer_just_ended(&g->get_timer[TIMER_TRANSITION]) && g->state == STATE_DEAD) {
-		game_restart(g);
-		timer_start(&g->get_timer[TIMER_TRANSITION]);
-	}
+	rewind_record(&g->rewind, &g->sim, g->sim.tick);
+	g->sim.update_us = game_us_since(update_start);
 }
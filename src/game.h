@@ -4,8 +4,8 @@
 #include <stdlib.h>  /* exit, EXIT_FAILURE, rand, srand, malloc, free */
 #include <stdbool.h> /* bool, true, false */
 #include <time.h>    /* time */
-#include <math.h>    /* cos, sin */
-#include <string.h>  /* memset, strcpy, strcat */
+#include <math.h>    /* cos, sin, ceilf */
+#include <string.h>  /* memset, strcmp */
 #include <stdint.h>  /* uint32_t */
 
 #include <SDL2/SDL.h>
@@ -14,39 +14,26 @@
 #include <SDL2/SDL_mixer.h>
 
 #include "common.h"
+#include "assets.h"
+#include "render_queue.h"
+#include "jobs.h"
+#include "softrast.h"
+#include "capture.h"
+#include "triple_buffer.h"
+#include "input.h"
 #include "timer.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "rewind.h"
+#include "savefile.h"
 #include "particles.h"
 #include "snake.h"
 #include "cheese.h"
-
-enum {
-	TEXTURE_EYES = 0,
-	TEXTURE_EYES_DEAD,
-	TEXTURE_TONGUE,
-	TEXTURE_GRASS1,
-	TEXTURE_GRASS2,
-	TEXTURE_CHEESE,
-	TEXTURE_TUTORIAL,
-	TEXTURE_PAUSED,
-	TEXTURE_YOU_LOST,
-	TEXTURE_SPACEBAR,
-
-	TEXTURES_COUNT,
-};
-
-enum {
-	SOUND_EAT = 0,
-	SOUND_HIT,
-	SOUND_DEATH,
-	SOUND_CHEESEBURGER,
-
-	SOUNDS_COUNT,
-};
-
-struct texture {
-	SDL_Texture *sdl;
-	int w, h;
-};
+#include "scenario.h"
+#include "planner.h"
+#include "hamilton.h"
+#include "bot.h"
+#include "quality.h"
 
 enum {
 	TIMER_SCR_SHAKE = 0,
@@ -56,6 +43,18 @@ enum {
 	TIMER_TRANSITION,
 
 	TIMERS_COUNT,
+
+	/* Timers owned by something else in the game, which still fire their events into it */
+	TIMER_SNAKE_TONGUE = TIMERS_COUNT,
+};
+
+/* Parts of the map that are recorded on their own, each one by a separate job */
+enum {
+	MAP_QUEUE_CHEESE = 0,
+	MAP_QUEUE_SNAKE,
+	MAP_QUEUE_PARTICLES,
+
+	MAP_QUEUES_COUNT,
 };
 
 enum state {
@@ -66,39 +65,134 @@ enum state {
 	STATE_DEAD,
 };
 
-struct game {
+/* Everything the simulation owns. The simulation thread publishes a copy of it after every tick,
+ * and the render thread only ever draws from the latest published copy. It holds no pointers, so
+ * that a copy of it is a complete game that can be rewound to or saved as is. */
+struct game_state {
 	enum state state;
 	size_t     tick;
 
+	/* The UI clock always runs, the gameplay clock only while the snake is out on the map */
+	struct timer_wheel ui_clock, play_clock;
+
 	struct particles particles;
 
+	struct snake       snake;
+	struct cheese_pool cheese_pool;
+
+	size_t score;
+
+	SDL_Point map_shake_pos;
+
+	bool darken_screen;
+
+	struct timer get_timer[TIMERS_COUNT];
+
+	/* How long the last tick took to update, and how much of that went into deciding where to go
+	 * and into finding a cell for new cheese. Published with the tick, so that the render thread
+	 * reads the times of the tick it draws. */
+	uint32_t update_us, think_us, spawn_us;
+};
+
+struct game {
+	struct game_state  sim;
+	struct game_state *view;
+
+	struct triple_buffer snapshots;
+	SDL_sem             *published, *woken;
+	struct input_queue   input;
+	SDL_Thread          *sim_thread;
+	SDL_atomic_t         quit;
+
+	struct rewind rewind;
+	const char   *save_path;
+
+	/* Multiplies SNAKE_SPEED */
+	float speed;
+
+	/* Games are counted on the simulation thread, frames are timed on the render thread */
+	bool               logging_telemetry;
+	struct telemetry   telemetry;
+	uint32_t           games;
+	struct frame_times frame_times;
+	Uint64             last_frame;
+
+	/* Unless --quality pins it, the level follows how long frames take to render */
+	bool                    governed;
+	struct quality_governor quality;
+
+	/* Every new game starts from the scenario instead of the usual board */
+	bool            has_scenario;
+	struct scenario scenario;
+
+	/* The AI plays on the simulation thread, pressing the same keys a player would. With
+	 * --hamilton, it follows a cycle through the whole map instead of planning. */
+	bool            ai, hamilton;
+	struct planner  planner;
+	struct hamilton cycle;
+
+	/* Bots loaded with --bot play instead, taking turns one game each */
+	char      *bot_paths;
+	struct bot bots[BOTS_CAPACITY];
+	size_t     bots_count, bot;
+
+	/* In lockstep, the simulation waits for every tick to be rendered before running the next one,
+	 * as fast as the renderer can go instead of in real time */
+	bool     lockstep;
+	SDL_sem *consumed;
+
+	/* Audio and fonts are initialised in the background, and are left out until they are ready */
+	Uint64       started;
+	bool         presented;
+	SDL_Thread  *audio_thread, *fonts_thread;
+	SDL_atomic_t audio_ready, fonts_ready;
+
 	SDL_Window   *win;
 	SDL_Renderer *ren;
 
+	struct render_queue queue;
+	struct render_stats render_stats;
+
+	/* How long the last frame took to render, without waiting on the simulation or on vsync */
+	uint32_t render_us;
+
+	/* Recorded on the workers and appended to the queue, with the textures they draw looked up
+	 * beforehand, since looking them up can load them */
+	struct jobs           jobs;
+	struct render_queue   map_queues[MAP_QUEUES_COUNT];
+	struct texture       *cheese_texture;
+	struct snake_textures snake_textures;
+
+	/* The map is rasterised on the CPU and streamed into the map texture */
+	bool            software;
+	struct softrast soft;
+
+	/* Frames are drawn into the capture target instead of the window while capturing */
+	bool           headless, capturing;
+	size_t         capture_limit;
+	struct capture capture;
+	SDL_Texture   *screen;
+
+	/* Idle while only the banners move, and hidden while the window is minimised or covered up.
+	 * Either way frames are drawn at a low rate, and key presses wake the simulation up early. */
+	bool idle, hidden;
+
 	SDL_Event    evt;
 	const Uint8 *keyboard;
 
-	struct snake       snake;
-	struct cheese_pool cheese_pool;
-
-	size_t score, prev_score;
+	enum state     rendered_state;
+	size_t         rendered_score;
 	struct texture score_texture;
 
 	SDL_Texture *map;
 	SDL_Rect     map_rect;
 
-	SDL_Point map_shake_pos;
-
-	bool darken_screen;
-
-	struct timer   get_timer[TIMERS_COUNT];
-	struct texture get_texture[TEXTURES_COUNT];
-	Mix_Chunk     *get_sound[SOUNDS_COUNT];
-	TTF_Font      *font;
+	struct assets assets;
 };
 
 void game_init(struct game *g);
 void game_finish(struct game *g);
+bool game_running(struct game *g);
 void game_render(struct game *g);
 void game_handle_events(struct game *g);
 void game_update(struct game *g);
@@ -0,0 +1,86 @@
+#include "hamilton.h"
+
+static void hamilton_add(struct hamilton *h, size_t *count, int x, int y, bool transpose) {
+	SDL_Point at = {
+		.x = transpose? y : x,
+		.y = transpose? x : y,
+	};
+
+	h->order[at.y][at.x] = *count;
+	h->cells[(*count) ++] = at;
+}
+
+/* Goes down and up the columns in pairs below the first row, and back along the first row to where
+ * it started. Which needs an even number of columns, or the same thing turned on its side. */
+void hamilton_init(struct hamilton *h) {
+	bool transpose = COLS % 2 != 0;
+	int  w = transpose? ROWS : COLS, len = transpose? COLS : ROWS;
+
+	size_t count = 0;
+	hamilton_add(h, &count, 0, 0, transpose);
+	for (int x = 0; x < w; ++ x) {
+		for (int i = 1; i < len; ++ i)
+			hamilton_add(h, &count, x, x % 2 == 0? i : len - i, transpose);
+	}
+
+	for (int x = w - 1; x > 0; -- x)
+		hamilton_add(h, &count, x, 0, transpose);
+}
+
+/* How many moves along the cycle it takes to get from a to b */
+static size_t hamilton_dist(size_t a, size_t b) {
+	return (b + HAMILTON_CELLS - a) % HAMILTON_CELLS;
+}
+
+static bool hamilton_inside(SDL_Point at) {
+	return at.x >= 0 && at.x < COLS && at.y >= 0 && at.y < ROWS;
+}
+
+static size_t hamilton_order(struct hamilton *h, SDL_Point at) {
+	return h->order[at.y][at.x];
+}
+
+enum dir hamilton_dir(struct hamilton *h, struct snake *s, struct cheese_pool *pool) {
+	SDL_Point head = snake_head(s);
+	if (!hamilton_inside(head))
+		return s->dir;
+
+	size_t    at   = hamilton_order(h, head);
+	SDL_Point next = h->cells[(at + 1) % HAMILTON_CELLS];
+	if (s->len * HAMILTON_SHORTCUT_DIV >= HAMILTON_CELLS || pool->count == 0)
+		return dir_from_a_to_b(head, next);
+
+	/* Cutting across never skips past the closest cheese ahead on the cycle */
+	size_t target = HAMILTON_CELLS;
+	for (size_t i = 0; i < pool->count; ++ i) {
+		size_t dist = hamilton_dist(at, hamilton_order(h, pool->get[i].at));
+		if (dist > 0 && dist < target)
+			target = dist;
+	}
+
+	/* Every cell the snake is yet to grow by takes up one more cell of the room ahead of the tail */
+	size_t grow = s->requested_grow + (cheese_pool_find(pool, head.x, head.y) != NULL);
+	size_t room = hamilton_dist(at, hamilton_order(h, snake_tail(s)));
+
+	size_t best = 1;
+	for (enum dir dir = UP; dir <= RIGHT; ++ dir) {
+		SDL_Point to = head;
+		switch (dir) {
+		case UP:    -- to.y; break;
+		case LEFT:  -- to.x; break;
+		case DOWN:  ++ to.y; break;
+		case RIGHT: ++ to.x; break;
+		}
+
+		if (!hamilton_inside(to) || snake_find(s, to, 0) < s->len)
+			continue;
+
+		size_t dist = hamilton_dist(at, hamilton_order(h, to));
+		if (dist > best && dist <= target && dist + grow + HAMILTON_SLACK < room) {
+			best = dist;
+			next = to;
+		}
+	}
+
+	return dir_from_a_to_b(head, next);
+}
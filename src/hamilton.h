@@ -0,0 +1,33 @@
+#ifndef HAMILTON_H_HEADER_GUARD
+#define HAMILTON_H_HEADER_GUARD
+
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint16_t */
+#include <assert.h>  /* static_assert */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "snake.h"
+#include "cheese.h"
+#include "config.h"
+
+#define HAMILTON_CELLS (ROWS * COLS)
+
+static_assert(ROWS >= 2 && COLS >= 2 && (ROWS % 2 == 0 || COLS % 2 == 0),
+              "A Hamiltonian cycle needs an even number of rows or of columns");
+static_assert(HAMILTON_CELLS <= UINT16_MAX, "Cycle positions have to fit into an uint16_t");
+
+/* A cycle through every cell of the map. A snake that only ever moves to the next cell on it can
+ * not run into itself, and ends up filling the whole map. Until it is long, it cuts across to cells
+ * further along the cycle on the way to the next cheese, as long as that keeps its body in the
+ * order of the cycle and leaves enough room ahead of the tail to grow into. */
+struct hamilton {
+	uint16_t  order[ROWS][COLS];
+	SDL_Point cells[HAMILTON_CELLS];
+};
+
+void     hamilton_init(struct hamilton *h);
+enum dir hamilton_dir(struct hamilton *h, struct snake *s, struct cheese_pool *pool);
+
+#endif
@@ -0,0 +1,27 @@
+#include "input.h"
+
+void input_queue_init(struct input_queue *q) {
+	SDL_AtomicSet(&q->head, 0);
+	SDL_AtomicSet(&q->tail, 0);
+}
+
+/* The counters only ever go up and are allowed to wrap around, hence the unsigned maths */
+bool input_queue_push(struct input_queue *q, struct input in) {
+	unsigned tail = SDL_AtomicGet(&q->tail);
+	if (tail - (unsigned)SDL_AtomicGet(&q->head) >= INPUT_QUEUE_CAPACITY)
+		return false;
+
+	q->get[tail % INPUT_QUEUE_CAPACITY] = in;
+	SDL_AtomicSet(&q->tail, tail + 1);
+	return true;
+}
+
+bool input_queue_pop(struct input_queue *q, struct input *in) {
+	unsigned head = SDL_AtomicGet(&q->head);
+	if (head == (unsigned)SDL_AtomicGet(&q->tail))
+		return false;
+
+	*in = q->get[head % INPUT_QUEUE_CAPACITY];
+	SDL_AtomicSet(&q->head, head + 1);
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef INPUT_H_HEADER_GUARD
+#define INPUT_H_HEADER_GUARD
+
+#include <stdbool.h> /* bool, true, false */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+
+struct input {
+	SDL_Keycode key;
+	Uint32      timestamp;
+};
+
+#define INPUT_QUEUE_CAPACITY 64
+
+/* Lock-free queue of key presses from the thread that polls the events to the thread that runs
+ * the simulation, with a single producer and a single consumer */
+struct input_queue {
+	struct input get[INPUT_QUEUE_CAPACITY];
+	SDL_atomic_t head, tail;
+};
+
+void input_queue_init(struct input_queue *q);
+bool input_queue_push(struct input_queue *q, struct input in);
+bool input_queue_pop(struct input_queue *q, struct input *in);
+
+#endif
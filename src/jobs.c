@@ -0,0 +1,202 @@
+#include "jobs.h"
+
+/* Index of the deque the current thread pushes into */
+static _Thread_local int jobs_deque;
+
+static bool jobs_push(struct jobs *js, struct job *job) {
+	struct job_deque *d = &js->deques[jobs_deque];
+
+	SDL_AtomicLock(&d->lock);
+	bool pushed = d->bottom - d->top < JOBS_CAPACITY;
+	if (pushed)
+		d->get[d->bottom ++ % JOBS_CAPACITY] = job;
+	SDL_AtomicUnlock(&d->lock);
+
+	if (pushed && SDL_AtomicGet(&js->sleeping) > 0)
+		SDL_SemPost(js->wake);
+
+	return pushed;
+}
+
+static struct job *jobs_pop(struct job_deque *d, bool steal) {
+	struct job *job = NULL;
+
+	SDL_AtomicLock(&d->lock);
+	if (d->bottom != d->top)
+		job = steal? d->get[d->top ++ % JOBS_CAPACITY] : d->get[-- d->bottom % JOBS_CAPACITY];
+	SDL_AtomicUnlock(&d->lock);
+
+	return job;
+}
+
+static struct job *jobs_next(struct jobs *js) {
+	struct job *job = jobs_pop(&js->deques[jobs_deque], false);
+
+	for (int i = 1; job == NULL && i <= js->workers_count; ++ i)
+		job = jobs_pop(&js->deques[(jobs_deque + i) % (js->workers_count + 1)], true);
+
+	return job;
+}
+
+static void jobs_finish(struct jobs *js, struct job *job) {
+	if (SDL_AtomicAdd(&job->unfinished, -1) != 1)
+		return;
+
+	for (int i = 0; i < job->dependents_count; ++ i)
+		jobs_submit(js, job->dependents[i]);
+
+	if (job->parent != NULL)
+		jobs_finish(js, job->parent);
+}
+
+static void jobs_run(struct jobs *js, struct job *job) {
+	if (job->range_fn != NULL)
+		job->range_fn(job->data, job->start, job->end);
+	else if (job->fn != NULL)
+		job->fn(job->data);
+
+	jobs_finish(js, job);
+}
+
+static int jobs_work(void *data) {
+	struct jobs *js = (struct jobs*)data;
+
+	jobs_deque = SDL_AtomicAdd(&js->started, 1) + 1;
+	trace_thread("worker");
+
+	while (!SDL_AtomicGet(&js->quit)) {
+		struct job *job = jobs_next(js);
+
+		/* Checking again once counted as sleeping means a push either gets seen here, or sees
+		 * this worker sleeping and wakes it up */
+		if (job == NULL) {
+			SDL_AtomicIncRef(&js->sleeping);
+
+			job = jobs_next(js);
+			if (job == NULL && !SDL_AtomicGet(&js->quit))
+				SDL_SemWait(js->wake);
+
+			SDL_AtomicAdd(&js->sleeping, -1);
+		}
+
+		if (job != NULL)
+			jobs_run(js, job);
+	}
+
+	return 0;
+}
+
+void jobs_init(struct jobs *js, int workers) {
+	memset(js, 0, sizeof(*js));
+
+	if (workers < 0)
+		workers = 0;
+	else if (workers > JOBS_MAX_WORKERS)
+		workers = JOBS_MAX_WORKERS;
+
+	js->pool   = (struct job*)malloc(sizeof(*js->pool) * JOBS_CAPACITY);
+	js->deques = (struct job_deque*)calloc(workers + 1, sizeof(*js->deques));
+	if (js->pool == NULL || js->deques == NULL)
+		UNREACHABLE("malloc() fail");
+
+	js->wake = SDL_CreateSemaphore(0);
+	if (js->wake == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	js->workers_count = workers;
+	for (int i = 0; i < workers; ++ i) {
+		js->workers[i] = SDL_CreateThread(jobs_work, "worker", js);
+		if (js->workers[i] == NULL) {
+			SDL_Log("%s", SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+void jobs_free(struct jobs *js) {
+	SDL_AtomicSet(&js->quit, true);
+	for (int i = 0; i < js->workers_count; ++ i)
+		SDL_SemPost(js->wake);
+
+	for (int i = 0; i < js->workers_count; ++ i)
+		SDL_WaitThread(js->workers[i], NULL);
+
+	SDL_DestroySemaphore(js->wake);
+	free(js->deques);
+	free(js->pool);
+}
+
+struct job *jobs_create(struct jobs *js, job_fn fn, void *data) {
+	struct job *job = &js->pool[(unsigned)SDL_AtomicAdd(&js->next, 1) % JOBS_CAPACITY];
+	memset(job, 0, sizeof(*job));
+
+	job->fn   = fn;
+	job->data = data;
+
+	/* Submitting is what the job waits on when it has no dependencies */
+	SDL_AtomicSet(&job->unfinished, 1);
+	SDL_AtomicSet(&job->pending,    1);
+	return job;
+}
+
+/* Both jobs have to be created but not submitted yet */
+void jobs_depend(struct job *job, struct job *on) {
+	if (on->dependents_count >= JOBS_MAX_DEPENDENTS)
+		UNREACHABLE("Too many dependents");
+
+	on->dependents[on->dependents_count ++] = job;
+	SDL_AtomicIncRef(&job->pending);
+}
+
+void jobs_submit(struct jobs *js, struct job *job) {
+	if (SDL_AtomicAdd(&job->pending, -1) != 1)
+		return;
+
+	/* With the deque full, the job runs right away instead */
+	if (!jobs_push(js, job))
+		jobs_run(js, job);
+}
+
+/* SDL_CPUPauseInstruction is only there since SDL 2.24 */
+static void jobs_pause(void) {
+#ifdef SDL_CPUPauseInstruction
+	SDL_CPUPauseInstruction();
+#endif
+}
+
+void jobs_wait(struct jobs *js, struct job *job) {
+	size_t empty = 0;
+	while (SDL_AtomicGet(&job->unfinished) > 0) {
+		struct job *next = jobs_next(js);
+		if (next != NULL) {
+			jobs_run(js, next);
+			empty = 0;
+		} else if (++ empty < JOBS_WAIT_SPINS)
+			jobs_pause();
+		else
+			SDL_Delay(0);
+	}
+}
+
+/* Splits [0, count) into ranges of grain items, the returned job is finished once all are */
+struct job *jobs_parallel_for(struct jobs *js, size_t count, size_t grain,
+                              job_range_fn fn, void *data) {
+	struct job *root = jobs_create(js, NULL, NULL);
+
+	for (size_t start = 0; start < count; start += grain) {
+		struct job *range = jobs_create(js, NULL, data);
+		range->range_fn = fn;
+		range->start    = start;
+		range->end      = start + grain < count? start + grain : count;
+		range->parent   = root;
+
+		SDL_AtomicIncRef(&root->unfinished);
+		jobs_submit(js, range);
+	}
+
+	/* The root has nothing to run itself */
+	jobs_finish(js, root);
+	return root;
+}
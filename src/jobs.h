@@ -0,0 +1,74 @@
+#ifndef JOBS_H_HEADER_GUARD
+#define JOBS_H_HEADER_GUARD
+
+#include <stdlib.h>  /* malloc, calloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <string.h>  /* memset */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "trace.h"
+#include "config.h"
+
+/* Jobs are handed out round-robin from a fixed pool, so a job has to be waited on long before
+ * JOBS_CAPACITY more jobs get created */
+#define JOBS_CAPACITY       4096
+#define JOBS_MAX_DEPENDENTS 4
+
+/* Waiting on a job that runs on another thread spins for this many empty polls, and yields the
+ * CPU between polls from then on */
+#define JOBS_WAIT_SPINS 64
+
+typedef void (*job_fn)(void *data);
+typedef void (*job_range_fn)(void *data, size_t start, size_t end);
+
+/* A job is unfinished for as long as it has not run or any of its children is unfinished, and it
+ * is only queued to run once every job it depends on is finished */
+struct job {
+	job_fn       fn;
+	job_range_fn range_fn;
+	void        *data;
+	size_t       start, end;
+
+	struct job  *parent;
+	SDL_atomic_t unfinished, pending;
+
+	struct job *dependents[JOBS_MAX_DEPENDENTS];
+	int         dependents_count;
+};
+
+/* The owner pushes and pops at the bottom, everyone else steals the oldest job from the top */
+struct job_deque {
+	SDL_SpinLock lock;
+	struct job  *get[JOBS_CAPACITY];
+	size_t       top, bottom;
+};
+
+/* Every worker has its own deque, and every thread that is not a worker shares the first one.
+ * Waiting on a job runs other jobs in the meantime, so no thread sits idle while there is work. */
+struct jobs {
+	struct job  *pool;
+	SDL_atomic_t next;
+
+	struct job_deque *deques;
+	SDL_Thread       *workers[JOBS_MAX_WORKERS];
+	int               workers_count;
+	SDL_atomic_t      started;
+
+	SDL_sem     *wake;
+	SDL_atomic_t sleeping, quit;
+};
+
+void jobs_init(struct jobs *js, int workers);
+void jobs_free(struct jobs *js);
+
+struct job *jobs_create(struct jobs *js, job_fn fn, void *data);
+void        jobs_depend(struct job *job, struct job *on);
+void        jobs_submit(struct jobs *js, struct job *job);
+void        jobs_wait(struct jobs *js, struct job *job);
+
+struct job *jobs_parallel_for(struct jobs *js, size_t count, size_t grain,
+                              job_range_fn fn, void *data);
+
+#endif
@@ -1,19 +1,32 @@
 #include <stdlib.h>  /* EXIT_SUCCESS */
 
 #include "game.h"
+#include "server.h"
 
 int main(int argc_, char **argv_) {
 	args(argc_, argv_);
 
+	/* Many headless games at once for clients on a socket, without a window */
+	const char *server_path = arg_value("--server");
+	if (server_path != NULL) {
+		struct server srv;
+		server_init(&srv, server_path);
+		server_run(&srv);
+		server_finish(&srv);
+		return EXIT_SUCCESS;
+	}
+
 	struct game g = {0};
 	game_init(&g);
 
-	while (g.state != STATE_QUIT) {
-		game_render(&g);
+	/* The simulation runs on its own thread, this one only handles the window */
+	while (game_running(&g)) {
+		Uint64 start = trace_begin();
+
 		game_handle_events(&g);
-		game_update(&g);
+		game_render(&g);
 
-		SDL_Delay(1000 / 60);
+		trace_end("frame", start);
 	}
 
 	game_finish(&g);
@@ -1,7 +1,7 @@
 #include "particles.h"
 
 void particle_start(struct particle *p, float vel, float fric, float angle, size_t time,
-                    SDL_Rect dims, int r, int g, int b) {
+                    SDL_Rect dims, int r, int g, int b, size_t now) {
 	p->x = dims.x;
 	p->y = dims.y;
 	p->w = dims.w;
@@ -13,32 +13,30 @@ void particle_start(struct particle *p, float vel, float fric, float angle, size
 	p->vel  = vel;
 	p->fric = fric;
 
-	timer_init(&p->timer, time);
-	timer_start(&p->timer);
+	p->start = now;
+	p->end   = now + time;
 
 	p->r = r;
 	p->g = g;
 	p->b = b;
 }
 
-bool particle_active(struct particle *p) {
-	return timer_active(&p->timer);
+bool particle_active(struct particle *p, size_t now) {
+	return now < p->end;
 }
 
-void particle_update(struct particle *p) {
-	if (!timer_active(&p->timer))
+void particle_update(struct particle *p, size_t now) {
+	if (!particle_active(p, now))
 		return;
 
 	p->x += p->dx * p->vel;
 	p->y += p->dy * p->vel;
 
 	p->vel *= p->fric;
-
-	timer_update(&p->timer);
 }
 
-void particle_render(struct particle *p, SDL_Renderer *ren) {
-	if (!timer_active(&p->timer))
+void particle_render(struct particle *p, struct render_queue *q, enum layer layer, size_t now) {
+	if (!particle_active(p, now))
 		return;
 
 	SDL_Rect r = {
@@ -48,20 +46,44 @@ void particle_render(struct particle *p, SDL_Renderer *ren) {
 		.h = p->h,
 	};
 
-	SDL_SetRenderDrawColor(ren, p->r, p->g, p->b, timer_unit(&p->timer, false) * 255);
-	SDL_RenderFillRect(ren, &r);
+	float unit = (float)(p->end - now) / (p->end - p->start);
+	render_queue_fill(q, layer, &r, p->r, p->g, p->b, unit * 255);
 }
 
 void particles_init(struct particles *p) {
 	memset(p->get, 0, sizeof(p->get));
 }
 
-void particles_update(struct particles *p) {
-	for (size_t i = 0; i < PARTICLES_CAPACITY; ++ i)
-		particle_update(&p->get[i]);
+void particles_update(struct particles *p, size_t now) {
+	particles_update_range(p, now, 0, PARTICLES_CAPACITY);
+}
+
+bool particles_active(struct particles *p, size_t now) {
+	for (size_t i = 0; i < PARTICLES_CAPACITY; ++ i) {
+		if (particle_active(&p->get[i], now))
+			return true;
+	}
+
+	return false;
+}
+
+/* Particles never touch each other, so separate ranges can be updated at the same time */
+void particles_update_range(struct particles *p, size_t now, size_t start, size_t end) {
+	Uint64 trace_start = trace_begin();
+	for (size_t i = start; i < end; ++ i)
+		particle_update(&p->get[i], now);
+
+	trace_end("particles_update", trace_start);
 }
 
-void particles_render(struct particles *p, SDL_Renderer *ren) {
-	for (size_t i = 0; i < PARTICLES_CAPACITY; ++ i)
-		particle_render(&p->get[i], ren);
+/* Draws no more than max of the particles that are alive */
+void particles_render(struct particles *p, struct render_queue *q, enum layer layer, size_t now,
+                      size_t max) {
+	for (size_t i = 0; i < PARTICLES_CAPACITY && max > 0; ++ i) {
+		if (!particle_active(&p->get[i], now))
+			continue;
+
+		-- max;
+		particle_render(&p->get[i], q, layer, now);
+	}
 }
@@ -6,22 +6,25 @@
 #include <SDL2/SDL.h>
 
 #include "common.h"
+#include "trace.h"
 #include "timer.h"
+#include "render_queue.h"
 
 struct particle {
 	float x, y, w, h, dx, dy;
 	float vel, fric;
 
-	struct timer timer;
+	/* Ticks of the clock that drives the particle, it is alive until it reaches the end */
+	size_t start, end;
 
 	int r, g, b;
 };
 
 void particle_start(struct particle *p, float vel, float fric, float angle, size_t time,
-                    SDL_Rect dims, int r, int g, int b);
-bool particle_active(struct particle *p);
-void particle_update(struct particle *p);
-void particle_render(struct particle *p, SDL_Renderer *ren);
+                    SDL_Rect dims, int r, int g, int b, size_t now);
+bool particle_active(struct particle *p, size_t now);
+void particle_update(struct particle *p, size_t now);
+void particle_render(struct particle *p, struct render_queue *q, enum layer layer, size_t now);
 
 #define PARTICLES_CAPACITY 256
 
@@ -30,7 +33,10 @@ struct particles {
 };
 
 void particles_init(struct particles *p);
-void particles_update(struct particles *p);
-void particles_render(struct particles *p, SDL_Renderer *ren);
+void particles_update(struct particles *p, size_t now);
+void particles_update_range(struct particles *p, size_t now, size_t start, size_t end);
+bool particles_active(struct particles *p, size_t now);
+void particles_render(struct particles *p, struct render_queue *q, enum layer layer, size_t now,
+                      size_t max);
 
 #endif
@@ -0,0 +1,205 @@
+#include "planner.h"
+
+/* xorshift32, every rollout gets its own so that they never share any state */
+static uint32_t planner_rand(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return *state = x;
+}
+
+/* Spreads the seeds of neighbouring rollouts apart, xorshift keeps similar seeds similar for a
+ * while otherwise */
+static uint32_t planner_seed(uint32_t seed, size_t i) {
+	uint32_t x = seed + (uint32_t)i * 0x9e3779b9;
+	x ^= x >> 16;
+	x *= 0x85ebca6b;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35;
+	x ^= x >> 16;
+
+	return x != 0? x : 1;
+}
+
+static bool planner_opposite(enum dir a, enum dir b) {
+	return (a - b) % 2 == 0 && a != b;
+}
+
+static SDL_Point planner_next_cell(SDL_Point at, enum dir dir) {
+	switch (dir) {
+	case UP:    -- at.y; break;
+	case LEFT:  -- at.x; break;
+	case DOWN:  ++ at.y; break;
+	case RIGHT: ++ at.x; break;
+	}
+
+	return at;
+}
+
+static bool planner_inside(SDL_Point at) {
+	return at.x >= 0 && at.x < COLS && at.y >= 0 && at.y < ROWS;
+}
+
+void planner_init(struct planner *p, struct jobs *js, uint32_t seed) {
+	memset(p, 0, sizeof(*p));
+
+	p->jobs = js;
+	p->seed = seed != 0? seed : 1;
+}
+
+/* Whether the cell is free to move into, the tail moves out of the way unless the snake grows */
+static bool planner_free(struct snake *s, SDL_Point at) {
+	if (!planner_inside(at))
+		return false;
+
+	size_t len = s->requested_grow > 0? s->len : s->len - 1;
+	return snake_find(s, at, 1) >= len;
+}
+
+/* A random direction that does not turn back, and that does not run into anything right away
+ * unless every one of them does */
+static enum dir planner_random_dir(struct snake *s, uint32_t *rng) {
+	enum dir dirs[3];
+	size_t   count = 0;
+
+	for (enum dir dir = UP; dir <= RIGHT; ++ dir) {
+		if (!planner_opposite(dir, s->dir) && planner_free(s, planner_next_cell(snake_head(s), dir)))
+			dirs[count ++] = dir;
+	}
+
+	if (count == 0)
+		return s->dir;
+
+	return dirs[planner_rand(rng) % count];
+}
+
+/* Plays one random game of up to AI_ROLLOUT_DEPTH cells on a copy of the board, starting with the
+ * given direction. Cheese is worth less the longer it takes to get to, biting off a part of the
+ * snake costs as much as the part was long, and dying ends the game at a loss. */
+static float planner_rollout(struct planner *p, enum dir first, uint32_t rng, bool *survived) {
+	struct planner_board b = p->board;
+
+	float value = 0, discount = 1;
+	for (size_t depth = 0; depth < AI_ROLLOUT_DEPTH; ++ depth) {
+		b.snake.dir = depth == 0? first : planner_random_dir(&b.snake, &rng);
+
+		SDL_Point at        = snake_head(&b.snake);
+		size_t    len       = b.snake.len;
+		bool      on_cheese = planner_inside(at) && b.cheese[at.y][at.x];
+
+		/* Every step moves by a whole cell */
+		struct snake_step step;
+		snake_step(&b.snake, 1, on_cheese, &step);
+
+		if (step.ate) {
+			b.cheese[at.y][at.x] = false;
+			value += discount;
+		}
+
+		if (step.bit_at > 0)
+			value -= (len - step.bit_at) * discount;
+
+		if (step.died) {
+			*survived = false;
+			return value - AI_DEATH_PENALTY;
+		}
+
+		discount *= AI_DISCOUNT;
+	}
+
+	*survived = true;
+	return value;
+}
+
+static void planner_rollouts(void *data, size_t start, size_t end) {
+	struct planner *p = (struct planner*)data;
+
+	for (size_t i = start; i < end; ++ i) {
+		p->results[i] = planner_rollout(p, p->candidates[i % p->candidates_count],
+		                                planner_seed(p->seed, i), &p->survived[i]);
+	}
+}
+
+/* A new decision starts whenever the snake moved on, or anything it could run into changed */
+static bool planner_same_decision(struct planner *p, struct snake *s, struct cheese_pool *pool) {
+	struct snake *prev = &p->board.snake;
+	SDL_Point     a    = snake_head(prev), b = snake_head(s);
+
+	return p->deciding && a.x == b.x && a.y == b.y && prev->len == s->len && prev->dir == s->dir &&
+	       p->board.cheese_count == pool->count;
+}
+
+static void planner_start(struct planner *p, struct snake *s, struct cheese_pool *pool) {
+	struct planner_board *b = &p->board;
+
+	b->snake = *s;
+	b->snake.turns_count = 0;
+
+	memset(b->cheese, 0, sizeof(b->cheese));
+	for (size_t i = 0; i < pool->count; ++ i) {
+		SDL_Point at = pool->get[i].at;
+		if (planner_inside(at))
+			b->cheese[at.y][at.x] = true;
+	}
+	b->cheese_count = pool->count;
+
+	p->candidates_count = 0;
+	for (enum dir dir = UP; dir <= RIGHT; ++ dir) {
+		if (!planner_opposite(dir, s->dir))
+			p->candidates[p->candidates_count ++] = dir;
+	}
+
+	memset(p->stats, 0, sizeof(p->stats));
+	p->deciding = true;
+}
+
+/* Runs batches of rollouts on the workers until the budget is used up, always at least one */
+void planner_think(struct planner *p, struct snake *s, struct cheese_pool *pool,
+                   Uint64 budget_us) {
+	Uint64 start = trace_begin();
+
+	if (!planner_same_decision(p, s, pool))
+		planner_start(p, s, pool);
+
+	Uint64 freq     = SDL_GetPerformanceFrequency();
+	Uint64 deadline = SDL_GetPerformanceCounter() + budget_us * freq / 1000000;
+
+	do {
+		planner_rand(&p->seed);
+
+		struct job *batch = jobs_parallel_for(p->jobs, AI_BATCH_ROLLOUTS, AI_ROLLOUT_GRAIN,
+		                                      planner_rollouts, p);
+		jobs_wait(p->jobs, batch);
+
+		for (size_t i = 0; i < AI_BATCH_ROLLOUTS; ++ i) {
+			struct planner_stats *stats = &p->stats[i % p->candidates_count];
+			++ stats->rollouts;
+			stats->survived += p->survived[i];
+			stats->value    += p->results[i];
+		}
+
+		p->rollouts += AI_BATCH_ROLLOUTS;
+	} while (SDL_GetPerformanceCounter() < deadline);
+
+	trace_end("planner_think", start);
+}
+
+/* The direction with the best average outcome, ties going to whichever survived more often */
+enum dir planner_best(struct planner *p) {
+	if (!p->deciding || p->candidates_count == 0)
+		return p->board.snake.dir;
+
+	size_t best = 0;
+	for (size_t i = 1; i < p->candidates_count; ++ i) {
+		struct planner_stats *a = &p->stats[i], *b = &p->stats[best];
+
+		double a_value = a->rollouts > 0? a->value / a->rollouts : 0;
+		double b_value = b->rollouts > 0? b->value / b->rollouts : 0;
+		if (a_value > b_value || (a_value == b_value && a->survived > b->survived))
+			best = i;
+	}
+
+	return p->candidates[best];
+}
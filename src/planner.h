@@ -0,0 +1,57 @@
+#ifndef PLANNER_H_HEADER_GUARD
+#define PLANNER_H_HEADER_GUARD
+
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* memset */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "jobs.h"
+#include "trace.h"
+#include "snake.h"
+#include "cheese.h"
+#include "config.h"
+
+/* Everything a rollout plays on, copied out of the game once per decision. Each rollout plays on
+ * its own copy of this, which is all it ever touches. */
+struct planner_board {
+	struct snake snake;
+	bool         cheese[ROWS][COLS];
+	size_t       cheese_count;
+};
+
+struct planner_stats {
+	size_t rollouts, survived;
+	double value;
+};
+
+/* Picks the direction to take into the next cell by playing out many short random games from each
+ * possible one on the job workers. The statistics of a decision keep piling up over every tick
+ * spent in the same cell, until the snake leaves it. */
+struct planner {
+	struct jobs *jobs;
+	uint32_t     seed;
+
+	struct planner_board board;
+	bool                 deciding;
+
+	enum dir             candidates[3];
+	struct planner_stats stats[3];
+	size_t               candidates_count;
+
+	/* Filled in by the rollouts of the current batch, one slot per rollout */
+	float results[AI_BATCH_ROLLOUTS];
+	bool  survived[AI_BATCH_ROLLOUTS];
+
+	size_t rollouts;
+};
+
+void planner_init(struct planner *p, struct jobs *js, uint32_t seed);
+
+void     planner_think(struct planner *p, struct snake *s, struct cheese_pool *pool,
+                       Uint64 budget_us);
+enum dir planner_best(struct planner *p);
+
+#endif
@@ -0,0 +1,74 @@
+#include "quality.h"
+
+static const struct quality_settings settings[QUALITY_LEVELS] = {
+	[QUALITY_LOW] = {
+		.name         = "low",
+		.particles    = 0.25,
+		.shake        = 0.3,
+		.shadows      = false,
+		.linear       = false,
+		.effect_draws = 32,
+	},
+	[QUALITY_MEDIUM] = {
+		.name         = "medium",
+		.particles    = 0.5,
+		.shake        = 0.6,
+		.shadows      = true,
+		.linear       = false,
+		.effect_draws = 128,
+	},
+	[QUALITY_HIGH] = {
+		.name         = "high",
+		.particles    = 1,
+		.shake        = 1,
+		.shadows      = true,
+		.linear       = true,
+		.effect_draws = PARTICLES_CAPACITY,
+	},
+};
+
+void quality_init(struct quality_governor *q, int level) {
+	memset(q, 0, sizeof(*q));
+	SDL_AtomicSet(&q->level, level);
+}
+
+/* Takes how long a frame took to render, true if the level changed because of it. Going down
+ * happens right after a slow window, going up only after a few fast ones in a row, so that the
+ * level does not keep flipping between two of them. */
+bool quality_frame(struct quality_governor *q, uint32_t us) {
+	q->us[q->count ++] = us;
+	if (q->count < QUALITY_WINDOW)
+		return false;
+
+	qsort(q->us, q->count, sizeof(*q->us), compare_u32);
+	uint32_t p95 = q->us[q->count * 95 / 100];
+	q->count = 0;
+
+	int level = SDL_AtomicGet(&q->level), was = level;
+	if (p95 > QUALITY_BUDGET_US) {
+		q->calm_windows = 0;
+		if (level > QUALITY_LOW)
+			-- level;
+	} else if (p95 < QUALITY_BUDGET_US / 2) {
+		if (++ q->calm_windows >= QUALITY_UP_WINDOWS && level < QUALITY_HIGH) {
+			q->calm_windows = 0;
+			++ level;
+		}
+	} else
+		q->calm_windows = 0;
+
+	if (level == was)
+		return false;
+
+	SDL_Log("Quality %s, 95th percentile of render times was %u us", settings[level].name, p95);
+	SDL_AtomicSet(&q->level, level);
+	return true;
+}
+
+int quality_level(struct quality_governor *q) {
+	return SDL_AtomicGet(&q->level);
+}
+
+const struct quality_settings *quality_settings(int level) {
+	return &settings[level];
+}
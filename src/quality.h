@@ -0,0 +1,47 @@
+#ifndef QUALITY_H_HEADER_GUARD
+#define QUALITY_H_HEADER_GUARD
+
+#include <stdlib.h>  /* qsort */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* memcpy */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "particles.h"
+#include "config.h"
+
+enum {
+	QUALITY_LOW = 0,
+	QUALITY_MEDIUM,
+	QUALITY_HIGH,
+
+	QUALITY_LEVELS,
+};
+
+/* What a level of quality draws. particles scales how many particles get emitted and shake how far
+ * the screen shakes, effect_draws caps the particles drawn by each of the effects. */
+struct quality_settings {
+	const char *name;
+	float       particles, shake;
+	bool        shadows, linear;
+	size_t      effect_draws;
+};
+
+/* Steps the quality up or down depending on how long the frames took to render. The level is
+ * changed by the render thread only, but the simulation reads it too. */
+struct quality_governor {
+	uint32_t     us[QUALITY_WINDOW];
+	size_t       count;
+	int          calm_windows;
+	SDL_atomic_t level;
+};
+
+void quality_init(struct quality_governor *q, int level);
+bool quality_frame(struct quality_governor *q, uint32_t us);
+int  quality_level(struct quality_governor *q);
+
+const struct quality_settings *quality_settings(int level);
+
+#endif
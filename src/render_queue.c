@@ -0,0 +1,262 @@
+#include "render_queue.h"
+#include "softrast.h"
+
+void render_queue_init(struct render_queue *q, SDL_Renderer *ren) {
+	memset(q, 0, sizeof(*q));
+
+	q->ren      = ren;
+	q->capacity = RENDER_QUEUE_CAPACITY;
+	q->cmds     = (struct render_cmd*)malloc(sizeof(*q->cmds)  * RENDER_QUEUE_CAPACITY);
+	q->rects    = (SDL_Rect*)         malloc(sizeof(*q->rects) * RENDER_QUEUE_CAPACITY);
+	if (q->cmds == NULL || q->rects == NULL)
+		UNREACHABLE("malloc() fail");
+}
+
+void render_queue_free(struct render_queue *q) {
+	free(q->cmds);
+	free(q->rects);
+}
+
+void render_queue_set_target(struct render_queue *q, struct softrast *soft) {
+	render_queue_flush(q);
+	q->soft = soft;
+}
+
+void render_queue_skip_layers(struct render_queue *q, uint32_t layers) {
+	q->skip_layers = layers;
+}
+
+static bool render_queue_skipped(struct render_queue *q, enum layer layer) {
+	return q->skip_layers & (uint32_t)1 << layer;
+}
+
+static size_t render_queue_texture_id(struct render_queue *q, SDL_Texture *texture) {
+	for (size_t i = 0; i < q->textures_count; ++ i) {
+		if (q->textures[i] == texture)
+			return i;
+	}
+
+	/* Running out of ids only makes the sorting worse, the draws still come out right */
+	if (q->textures_count >= RENDER_QUEUE_TEXTURES)
+		return RENDER_QUEUE_TEXTURES - 1;
+
+	q->textures[q->textures_count] = texture;
+	return q->textures_count ++;
+}
+
+static uint64_t render_cmd_key(struct render_queue *q, struct render_cmd *cmd, enum layer layer) {
+	uint64_t texture_id = cmd->type == RENDER_CMD_COPY? render_queue_texture_id(q, cmd->texture) : 0;
+	uint64_t color      = (uint64_t)cmd->color.r << 24 | (uint64_t)cmd->color.g << 16 |
+	                      (uint64_t)cmd->color.b << 8  | (uint64_t)cmd->color.a;
+
+	return (uint64_t)layer << 56 | (uint64_t)cmd->type << 48 | texture_id << 40 |
+	       (uint64_t)(cmd->blend & 0xff) << 32 | color;
+}
+
+static struct render_cmd *render_queue_push(struct render_queue *q) {
+	if (q->count >= q->capacity && q->ren == NULL) {
+		/* There is nothing to flush a recording into, so it grows instead */
+		q->capacity *= 2;
+		q->cmds      = (struct render_cmd*)realloc(q->cmds, sizeof(*q->cmds) * q->capacity);
+		if (q->cmds == NULL)
+			UNREACHABLE("realloc() fail");
+	} else if (q->count >= q->capacity)
+		render_queue_flush(q);
+
+	struct render_cmd *cmd = &q->cmds[q->count];
+	memset(cmd, 0, sizeof(*cmd));
+
+	cmd->seq   = q->count ++;
+	cmd->blend = SDL_BLENDMODE_BLEND;
+	return cmd;
+}
+
+void render_queue_fill(struct render_queue *q, enum layer layer, SDL_Rect *r,
+                       int red, int green, int blue, int alpha) {
+	if (render_queue_skipped(q, layer))
+		return;
+
+	struct render_cmd *cmd = render_queue_push(q);
+
+	cmd->type    = RENDER_CMD_FILL;
+	cmd->dest    = *r;
+	cmd->color.r = red;
+	cmd->color.g = green;
+	cmd->color.b = blue;
+	cmd->color.a = alpha;
+	cmd->key     = render_cmd_key(q, cmd, layer);
+}
+
+void render_queue_copy_ex(struct render_queue *q, enum layer layer, SDL_Texture *texture,
+                          SDL_Rect *src, SDL_Rect *dest, double angle, int alpha) {
+	if (render_queue_skipped(q, layer))
+		return;
+
+	struct render_cmd *cmd = render_queue_push(q);
+
+	cmd->type    = RENDER_CMD_COPY;
+	cmd->texture = texture;
+	cmd->dest    = *dest;
+	cmd->angle   = angle;
+	cmd->color.a = alpha;
+
+	if (src != NULL) {
+		cmd->src     = *src;
+		cmd->has_src = true;
+	}
+
+	cmd->key = render_cmd_key(q, cmd, layer);
+}
+
+void render_queue_copy(struct render_queue *q, enum layer layer, SDL_Texture *texture,
+                       SDL_Rect *src, SDL_Rect *dest) {
+	render_queue_copy_ex(q, layer, texture, src, dest, 0, SDL_ALPHA_OPAQUE);
+}
+
+void render_queue_copy_shadow_ex(struct render_queue *q, enum layer layer, SDL_Texture *shadow,
+                                 SDL_Rect *src, SDL_Rect *dest, double angle, int offset) {
+	SDL_Rect r = *dest;
+	r.x += offset;
+	r.y += offset;
+
+	render_queue_copy_ex(q, layer, shadow, src, &r, angle, SDL_ALPHA_OPAQUE);
+}
+
+void render_queue_copy_shadow(struct render_queue *q, enum layer layer, SDL_Texture *shadow,
+                              SDL_Rect *src, SDL_Rect *dest, int offset) {
+	render_queue_copy_shadow_ex(q, layer, shadow, src, dest, 0, offset);
+}
+
+static int render_cmd_compare(const void *a_, const void *b_) {
+	const struct render_cmd *a = (const struct render_cmd*)a_;
+	const struct render_cmd *b = (const struct render_cmd*)b_;
+
+	if (a->key != b->key)
+		return a->key < b->key? -1 : 1;
+
+	return a->seq < b->seq? -1 : a->seq > b->seq;
+}
+
+static void render_queue_flush_fills(struct render_queue *q, size_t from, size_t to,
+                                     SDL_Color *color, bool *color_set, SDL_BlendMode *blend) {
+	struct render_cmd *first = &q->cmds[from];
+
+	if (*blend != first->blend) {
+		SDL_SetRenderDrawBlendMode(q->ren, first->blend);
+		*blend = first->blend;
+		++ q->stats.state_changes;
+	}
+
+	SDL_Color c = first->color;
+	if (!*color_set || color->r != c.r || color->g != c.g || color->b != c.b || color->a != c.a) {
+		SDL_SetRenderDrawColor(q->ren, c.r, c.g, c.b, c.a);
+		*color     = c;
+		*color_set = true;
+		++ q->stats.state_changes;
+	}
+
+	for (size_t i = from; i < to; ++ i)
+		q->rects[i - from] = q->cmds[i].dest;
+
+	SDL_RenderFillRects(q->ren, q->rects, to - from);
+	++ q->stats.draw_calls;
+}
+
+static void render_queue_flush_copies(struct render_queue *q, size_t from, size_t to,
+                                      SDL_Texture **texture) {
+	struct render_cmd *first = &q->cmds[from];
+
+	if (*texture != first->texture) {
+		*texture = first->texture;
+		++ q->stats.state_changes;
+	}
+
+	bool modded = first->color.a != SDL_ALPHA_OPAQUE;
+	if (modded) {
+		SDL_SetTextureAlphaMod(first->texture, first->color.a);
+		++ q->stats.state_changes;
+	}
+
+	for (size_t i = from; i < to; ++ i) {
+		struct render_cmd *cmd = &q->cmds[i];
+		SDL_Rect          *src = cmd->has_src? &cmd->src : NULL;
+
+		/* Running out of texture ids can put different textures under the same key */
+		if (cmd->texture != *texture) {
+			*texture = cmd->texture;
+			++ q->stats.state_changes;
+		}
+
+		if (cmd->angle == 0)
+			SDL_RenderCopy(q->ren, cmd->texture, src, &cmd->dest);
+		else
+			SDL_RenderCopyEx(q->ren, cmd->texture, src, &cmd->dest, cmd->angle, NULL, SDL_FLIP_NONE);
+
+		++ q->stats.draw_calls;
+	}
+
+	if (modded)
+		SDL_SetTextureAlphaMod(first->texture, SDL_ALPHA_OPAQUE);
+}
+
+/* Moves the recorded draws over in the order they were recorded in */
+void render_queue_append(struct render_queue *q, struct render_queue *from) {
+	for (size_t i = 0; i < from->count; ++ i) {
+		struct render_cmd *cmd = render_queue_push(q);
+		uint32_t           seq = cmd->seq;
+
+		*cmd     = from->cmds[i];
+		cmd->seq = seq;
+		cmd->key = render_cmd_key(q, cmd, from->cmds[i].key >> 56);
+	}
+
+	from->count          = 0;
+	from->textures_count = 0;
+}
+
+void render_queue_flush(struct render_queue *q) {
+	qsort(q->cmds, q->count, sizeof(*q->cmds), render_cmd_compare);
+
+	if (q->soft != NULL) {
+		softrast_draw(q->soft, q->cmds, q->count);
+
+		q->stats.cmds     += q->count;
+		q->count          = 0;
+		q->textures_count = 0;
+		return;
+	}
+
+	/* Whatever was drawn outside of the queue could have changed the draw colour */
+	SDL_Color     color     = {0};
+	bool          color_set = false;
+	SDL_BlendMode blend     = SDL_BLENDMODE_BLEND;
+	SDL_Texture  *texture   = NULL;
+
+	size_t from = 0;
+	while (from < q->count) {
+		size_t to = from + 1;
+		while (to < q->count && q->cmds[to].key == q->cmds[from].key)
+			++ to;
+
+		if (q->cmds[from].type == RENDER_CMD_FILL)
+			render_queue_flush_fills(q, from, to, &color, &color_set, &blend);
+		else
+			render_queue_flush_copies(q, from, to, &texture);
+
+		from = to;
+	}
+
+	if (blend != SDL_BLENDMODE_BLEND)
+		SDL_SetRenderDrawBlendMode(q->ren, SDL_BLENDMODE_BLEND);
+
+	q->stats.cmds     += q->count;
+	q->count          = 0;
+	q->textures_count = 0;
+}
+
+struct render_stats render_queue_take_stats(struct render_queue *q) {
+	struct render_stats stats = q->stats;
+	memset(&q->stats, 0, sizeof(q->stats));
+
+	return stats;
+}
@@ -0,0 +1,108 @@
+#ifndef RENDER_QUEUE_H_HEADER_GUARD
+#define RENDER_QUEUE_H_HEADER_GUARD
+
+#include <stdlib.h>  /* malloc, free, qsort */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint64_t, uint32_t */
+#include <string.h>  /* memset */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+
+/* A queue without a renderer only records draws, which another queue then appends. Recording
+ * touches nothing but the queue itself, so separate queues can be recorded on separate threads.
+ *
+ * Draws are sorted by layer first, so layers are the only thing that decides what ends up on top
+ * of what. Inside of a layer, draws are grouped by texture and colour, which is only fine because
+ * nothing drawn into the same layer overlaps in a way where the order would matter. */
+enum layer {
+	LAYER_GRASS = 0,
+	LAYER_GRASS_SHADOW,
+	LAYER_CHEESE_PARTICLES,
+	LAYER_CHEESE_SHADOW,
+	LAYER_CHEESE,
+	LAYER_SNAKE_SHADOW,
+	LAYER_SNAKE,
+	LAYER_SNAKE_FACE,
+	LAYER_PARTICLES,
+
+	LAYER_UI_FADE,
+	LAYER_UI_SHADOW,
+	LAYER_UI,
+	LAYER_UI_TRANSITION,
+
+	LAYERS_COUNT,
+};
+
+enum render_cmd_type {
+	RENDER_CMD_FILL = 0,
+	RENDER_CMD_COPY,
+};
+
+struct render_cmd {
+	uint64_t key;
+	uint32_t seq;
+
+	enum render_cmd_type type;
+	SDL_BlendMode        blend;
+
+	SDL_Texture *texture;
+	SDL_Rect     src, dest;
+	bool         has_src;
+	double       angle;
+
+	/* The fill colour, or the alpha mod of a copy */
+	SDL_Color color;
+};
+
+struct render_stats {
+	size_t cmds, draw_calls, state_changes;
+};
+
+#define RENDER_QUEUE_CAPACITY 2048
+#define RENDER_QUEUE_TEXTURES 64
+
+struct softrast;
+
+struct render_queue {
+	SDL_Renderer *ren;
+
+	/* When set, flushes rasterise into it instead of going through the renderer */
+	struct softrast *soft;
+
+	struct render_cmd *cmds;
+	size_t             count, capacity;
+
+	SDL_Texture *textures[RENDER_QUEUE_TEXTURES];
+	size_t       textures_count;
+
+	SDL_Rect *rects;
+
+	/* Layers with their bit set are left out, which is how whole passes get turned off */
+	uint32_t skip_layers;
+
+	struct render_stats stats;
+};
+
+void render_queue_init(struct render_queue *q, SDL_Renderer *ren);
+void render_queue_free(struct render_queue *q);
+void render_queue_set_target(struct render_queue *q, struct softrast *soft);
+void render_queue_skip_layers(struct render_queue *q, uint32_t layers);
+
+void render_queue_fill(struct render_queue *q, enum layer layer, SDL_Rect *r,
+                       int red, int green, int blue, int alpha);
+void render_queue_copy(struct render_queue *q, enum layer layer, SDL_Texture *texture,
+                       SDL_Rect *src, SDL_Rect *dest);
+void render_queue_copy_ex(struct render_queue *q, enum layer layer, SDL_Texture *texture,
+                          SDL_Rect *src, SDL_Rect *dest, double angle, int alpha);
+void render_queue_copy_shadow(struct render_queue *q, enum layer layer, SDL_Texture *shadow,
+                              SDL_Rect *src, SDL_Rect *dest, int offset);
+void render_queue_copy_shadow_ex(struct render_queue *q, enum layer layer, SDL_Texture *shadow,
+                                 SDL_Rect *src, SDL_Rect *dest, double angle, int offset);
+
+void render_queue_append(struct render_queue *q, struct render_queue *from);
+void render_queue_flush(struct render_queue *q);
+struct render_stats render_queue_take_stats(struct render_queue *q);
+
+#endif
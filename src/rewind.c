@@ -0,0 +1,174 @@
+#include "rewind.h"
+
+static size_t rewind_put_varint(uint8_t *out, uint32_t v) {
+	size_t n = 0;
+	while (v >= 0x80) {
+		out[n ++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+
+	out[n ++] = v;
+	return n;
+}
+
+static size_t rewind_get_varint(const uint8_t *in, uint32_t *v) {
+	size_t n     = 0;
+	int    shift = 0;
+
+	*v = 0;
+	do {
+		*v    |= (uint32_t)(in[n] & 0x7f) << shift;
+		shift += 7;
+	} while (in[n ++] & 0x80);
+
+	return n;
+}
+
+static size_t rewind_encoded_bound(size_t size) {
+	return size + (size / REWIND_MIN_ZERO_RUN + 1) * 10;
+}
+
+/* Encodes state XOR base as runs of zero bytes to skip, each followed by a run of literal bytes.
+ * Without a base, the state is encoded against all zeros. */
+static size_t rewind_encode(uint8_t *out, const uint8_t *state, const uint8_t *base, size_t size) {
+#define XOR_AT(I) (base != NULL? state[I] ^ base[I] : state[I])
+	size_t n = 0, i = 0;
+	while (i < size) {
+		size_t skip_from = i;
+		while (i < size && XOR_AT(i) == 0)
+			++ i;
+
+		/* Trailing zeros do not need a run */
+		if (i >= size)
+			break;
+
+		size_t lit_from = i, zeros = 0;
+		while (i < size && zeros < REWIND_MIN_ZERO_RUN) {
+			zeros = XOR_AT(i) == 0? zeros + 1 : 0;
+			++ i;
+		}
+
+		size_t lit_to = i - zeros;
+		n += rewind_put_varint(out + n, lit_from - skip_from);
+		n += rewind_put_varint(out + n, lit_to - lit_from);
+		for (size_t j = lit_from; j < lit_to; ++ j)
+			out[n ++] = XOR_AT(j);
+
+		i = lit_to;
+	}
+#undef XOR_AT
+
+	return n;
+}
+
+static void rewind_apply(uint8_t *state, const uint8_t *data, size_t size) {
+	size_t pos = 0, i = 0;
+	while (i < size) {
+		uint32_t skip, len;
+		i += rewind_get_varint(data + i, &skip);
+		i += rewind_get_varint(data + i, &len);
+
+		pos += skip;
+		for (uint32_t j = 0; j < len; ++ j)
+			state[pos + j] ^= data[i + j];
+
+		pos += len;
+		i   += len;
+	}
+}
+
+void rewind_init(struct rewind *r, size_t size) {
+	memset(r, 0, sizeof(*r));
+
+	r->size    = size;
+	r->prev    = (uint8_t*)malloc(size);
+	r->scratch = (uint8_t*)malloc(rewind_encoded_bound(size));
+	if (r->prev == NULL || r->scratch == NULL)
+		UNREACHABLE("malloc() fail");
+}
+
+void rewind_free(struct rewind *r) {
+	for (size_t i = 0; i < REWIND_CAPACITY; ++ i)
+		free(r->entries[i].data);
+
+	free(r->prev);
+	free(r->scratch);
+}
+
+void rewind_reset(struct rewind *r) {
+	r->start     = 0;
+	r->count     = 0;
+	r->since_key = 0;
+}
+
+static struct rewind_entry *rewind_entry(struct rewind *r, size_t i) {
+	return &r->entries[(r->start + i) % REWIND_CAPACITY];
+}
+
+void rewind_record(struct rewind *r, const void *state, size_t tick) {
+	bool   key  = r->count == 0 || r->since_key + 1 >= REWIND_KEYFRAME_TICKS;
+	size_t size = rewind_encode(r->scratch, (const uint8_t*)state, key? NULL : r->prev, r->size);
+
+	/* Once full, the oldest entry makes room, and its buffer gets reused */
+	struct rewind_entry *e;
+	if (r->count < REWIND_CAPACITY)
+		e = rewind_entry(r, r->count ++);
+	else {
+		e = rewind_entry(r, 0);
+		r->start = (r->start + 1) % REWIND_CAPACITY;
+	}
+
+	if (e->capacity < size) {
+		e->data = (uint8_t*)realloc(e->data, size);
+		if (e->data == NULL)
+			UNREACHABLE("realloc() fail");
+
+		e->capacity = size;
+	}
+
+	/* A tick that changed nothing encodes to nothing */
+	if (size > 0)
+		memcpy(e->data, r->scratch, size);
+
+	e->size = size;
+	e->tick = tick;
+	e->key  = key;
+
+	r->since_key = key? 0 : r->since_key + 1;
+	memcpy(r->prev, state, r->size);
+}
+
+/* Restores the latest recorded state at or before the tick, or the oldest one that can still be
+ * restored if the tick is older than that, and forgets everything recorded after it */
+bool rewind_restore(struct rewind *r, size_t tick, void *state, size_t *restored) {
+	size_t last = r->count;
+	while (last > 0 && rewind_entry(r, last - 1)->tick > tick)
+		-- last;
+
+	size_t key = last > 0? last - 1 : 0;
+	while (key > 0 && !rewind_entry(r, key)->key)
+		-- key;
+
+	/* The oldest deltas lose their keyframe once it gets overwritten */
+	while (key < r->count && !rewind_entry(r, key)->key)
+		++ key;
+
+	if (key >= r->count)
+		return false;
+
+	if (last <= key)
+		last = key + 1;
+
+	memset(state, 0, r->size);
+	for (size_t i = key; i < last; ++ i) {
+		struct rewind_entry *e = rewind_entry(r, i);
+		rewind_apply((uint8_t*)state, e->data, e->size);
+	}
+
+	r->count     = last;
+	r->since_key = last - 1 - key;
+	memcpy(r->prev, state, r->size);
+
+	*restored = rewind_entry(r, last - 1)->tick;
+	return true;
+}
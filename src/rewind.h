@@ -0,0 +1,45 @@
+#ifndef REWIND_H_HEADER_GUARD
+#define REWIND_H_HEADER_GUARD
+
+#include <stdlib.h>  /* malloc, realloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint8_t, uint32_t */
+#include <string.h>  /* memset, memcpy */
+
+#include "common.h"
+#include "config.h"
+
+#define REWIND_CAPACITY (REWIND_SECONDS * TICK_RATE)
+
+/* Runs of fewer zero bytes than this are kept inside of a literal run, since starting a new run
+ * would cost more than the zeros */
+#define REWIND_MIN_ZERO_RUN 4
+
+struct rewind_entry {
+	size_t   tick;
+	bool     key;
+	uint8_t *data;
+	size_t   size, capacity;
+};
+
+/* History of the last REWIND_CAPACITY recorded states, each one stored as the XOR with the state
+ * recorded before it, run length encoded, since only a small part of the state changes in a tick.
+ * Every REWIND_KEYFRAME_TICKS a keyframe is stored against all zeros instead, so restoring never
+ * has to apply more than that many deltas. The states have to be plain memory. */
+struct rewind {
+	size_t   size;
+	uint8_t *prev, *scratch;
+
+	struct rewind_entry entries[REWIND_CAPACITY];
+	size_t              start, count;
+	size_t              since_key;
+};
+
+void rewind_init(struct rewind *r, size_t size);
+void rewind_free(struct rewind *r);
+void rewind_reset(struct rewind *r);
+
+void rewind_record(struct rewind *r, const void *state, size_t tick);
+bool rewind_restore(struct rewind *r, size_t tick, void *state, size_t *restored);
+
+#endif
@@ -0,0 +1,83 @@
+#include "savefile.h"
+
+/* Goes through a temporary file next to the save, which only replaces the old save once it was
+ * written completely, so that a failed or interrupted save leaves the last one as it was */
+bool savefile_write(const char *path, const void *state, size_t size) {
+	char *tmp_path = (char*)malloc(strlen(path) + sizeof(".tmp"));
+	if (tmp_path == NULL)
+		UNREACHABLE("malloc() fail");
+
+	strcpy(tmp_path, path);
+	strcat(tmp_path, ".tmp");
+
+	FILE *f = fopen(tmp_path, "wb");
+	if (f == NULL) {
+		SDL_Log("Could not open '%s' for saving", tmp_path);
+		free(tmp_path);
+		return false;
+	}
+
+	struct savefile_header header = {
+		.version = SAVEFILE_VERSION,
+		.size    = size,
+	};
+	memcpy(header.magic, SAVEFILE_MAGIC, sizeof(header.magic));
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(state, size, 1, f) == 1 &&
+	          fflush(f) == 0;
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (ok && rename(tmp_path, path) != 0) {
+		SDL_Log("Could not replace '%s' with '%s'", path, tmp_path);
+		ok = false;
+	} else if (!ok)
+		SDL_Log("Could not write the save to '%s'", tmp_path);
+
+	if (!ok)
+		remove(tmp_path);
+
+	free(tmp_path);
+	return ok;
+}
+
+/* Leaves the state untouched unless the whole save could be read and passes the check */
+bool savefile_read(const char *path, void *state, size_t size, savefile_valid_fn valid) {
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		SDL_Log("Could not open '%s' for loading", path);
+		return false;
+	}
+
+	struct savefile_header header;
+	bool ok = fread(&header, sizeof(header), 1, f) == 1;
+	if (!ok)
+		SDL_Log("'%s' is too short to be a save", path);
+	else if (memcmp(header.magic, SAVEFILE_MAGIC, sizeof(header.magic)) != 0) {
+		SDL_Log("'%s' is not a save", path);
+		ok = false;
+	} else if (header.version != SAVEFILE_VERSION || header.size != size) {
+		SDL_Log("'%s' was saved by a different version of the game", path);
+		ok = false;
+	}
+
+	if (ok) {
+		void *data = malloc(size);
+		if (data == NULL)
+			UNREACHABLE("malloc() fail");
+
+		ok = fread(data, size, 1, f) == 1;
+		if (!ok)
+			SDL_Log("'%s' is cut short", path);
+		else if (!valid(data)) {
+			SDL_Log("'%s' does not hold a game that could be played", path);
+			ok = false;
+		} else
+			memcpy(state, data, size);
+
+		free(data);
+	}
+
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef SAVEFILE_H_HEADER_GUARD
+#define SAVEFILE_H_HEADER_GUARD
+
+#include <stdio.h>   /* FILE, fopen, fclose, fread, fwrite, fflush, rename, remove */
+#include <stdlib.h>  /* malloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t, uint64_t */
+#include <string.h>  /* memcmp, memcpy, strlen, strcpy, strcat */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+
+#define SAVEFILE_MAGIC   "CNKS"
+#define SAVEFILE_VERSION 1
+
+/* The game state is written out as is after a small header, so a save only loads into the same
+ * build of the game, which the size check catches most of the time. Since the file can still have
+ * been changed by anyone, the state is handed to a check of its own before it gets loaded. */
+struct savefile_header {
+	char     magic[4];
+	uint32_t version;
+	uint64_t size;
+};
+
+typedef bool (*savefile_valid_fn)(void *state);
+
+bool savefile_write(const char *path, const void *state, size_t size);
+bool savefile_read(const char *path, void *state, size_t size, savefile_valid_fn valid);
+
+#endif
@@ -0,0 +1,266 @@
+#include "scenario.h"
+#include "game.h"
+
+static const char *state_names[] = {
+	[STATE_TUTORIAL] = "tutorial",
+	[STATE_GAMEPLAY] = "gameplay",
+	[STATE_PAUSED]   = "paused",
+	[STATE_DEAD]     = "dead",
+};
+
+static const char *timer_names[TIMERS_COUNT] = {
+	[TIMER_SCR_SHAKE]  = "shake",
+	[TIMER_FADE_IN]    = "fade_in",
+	[TIMER_FADE_OUT]   = "fade_out",
+	[TIMER_DEAD]       = "dead",
+	[TIMER_TRANSITION] = "transition",
+};
+
+static const char *dir_names[] = {
+	[UP]    = "up",
+	[LEFT]  = "left",
+	[DOWN]  = "down",
+	[RIGHT] = "right",
+};
+
+static int scenario_find_name(const char **names, size_t count, const char *name) {
+	for (size_t i = 0; i < count; ++ i) {
+		if (names[i] != NULL && name != NULL && strcmp(names[i], name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+static bool scenario_parse_count(const char *token, size_t *count) {
+	if (token == NULL)
+		return false;
+
+	char *end;
+	*count = strtoul(token, &end, 10);
+	return end != token && *end == '\0';
+}
+
+static bool scenario_parse_point(const char *token, SDL_Point *p) {
+	int n;
+	if (sscanf(token, "%i,%i%n", &p->x, &p->y, &n) != 2 || token[n] != '\0')
+		return false;
+
+	return p->x >= 0 && p->x < COLS && p->y >= 0 && p->y < ROWS;
+}
+
+static bool scenario_taken(struct scenario *s, SDL_Point p) {
+	for (size_t i = 0; i < s->len; ++ i) {
+		if (s->body[i].x == p.x && s->body[i].y == p.y)
+			return true;
+	}
+
+	for (size_t i = 0; i < s->cheese_count; ++ i) {
+		if (s->cheese[i].x == p.x && s->cheese[i].y == p.y)
+			return true;
+	}
+
+	return false;
+}
+
+/* xorshift32, so that the same file always generates the same board */
+static uint32_t scenario_rand(struct scenario *s) {
+	s->seed ^= s->seed << 13;
+	s->seed ^= s->seed >> 17;
+	s->seed ^= s->seed << 5;
+	return s->seed;
+}
+
+static void scenario_face(struct scenario *s) {
+	if (s->len >= 2)
+		s->dir = dir_from_a_to_b(s->body[1], s->body[0]);
+}
+
+static bool scenario_add_snake(struct scenario *s, SDL_Point p) {
+	if (s->len >= MAX_SNAKE_LEN || scenario_taken(s, p))
+		return false;
+
+	if (s->len > 0) {
+		SDL_Point prev = s->body[s->len - 1];
+		if (abs(prev.x - p.x) + abs(prev.y - p.y) != 1)
+			return false;
+	}
+
+	s->body[s->len ++] = p;
+	return true;
+}
+
+/* Winds back and forth over the rows, which is as tightly as the snake can be packed */
+static bool scenario_coil(struct scenario *s, size_t len) {
+	if (len == 0 || len > MAX_SNAKE_LEN || len > ROWS * COLS)
+		return false;
+
+	s->len = 0;
+	for (size_t i = 0; i < len; ++ i) {
+		size_t    cell = len - 1 - i;
+		size_t    row  = cell / COLS;
+		SDL_Point p    = {
+			.x = row % 2 == 0? cell % COLS : COLS - 1 - cell % COLS,
+			.y = row,
+		};
+
+		if (!scenario_add_snake(s, p))
+			return false;
+	}
+
+	return true;
+}
+
+static bool scenario_add_cheese(struct scenario *s, SDL_Point p) {
+	if (s->cheese_count >= CHEESE_CAPACITY || scenario_taken(s, p))
+		return false;
+
+	s->cheese[s->cheese_count ++] = p;
+	return true;
+}
+
+static void scenario_fill_cheese(struct scenario *s) {
+	for (int y = 0; y < ROWS; ++ y) {
+		for (int x = 0; x < COLS; ++ x)
+			scenario_add_cheese(s, (SDL_Point){ .x = x, .y = y });
+	}
+}
+
+static bool scenario_random_cheese(struct scenario *s, size_t count) {
+	SDL_Point free_cells[ROWS * COLS];
+	size_t    free_count = 0;
+
+	for (int y = 0; y < ROWS; ++ y) {
+		for (int x = 0; x < COLS; ++ x) {
+			SDL_Point p = { .x = x, .y = y };
+			if (!scenario_taken(s, p))
+				free_cells[free_count ++] = p;
+		}
+	}
+
+	if (count > free_count)
+		return false;
+
+	/* A partial Fisher-Yates shuffle picks them without repeats */
+	for (size_t i = 0; i < count; ++ i) {
+		size_t j = i + scenario_rand(s) % (free_count - i);
+
+		SDL_Point tmp = free_cells[i];
+		free_cells[i] = free_cells[j];
+		free_cells[j] = tmp;
+
+		scenario_add_cheese(s, free_cells[i]);
+	}
+
+	return true;
+}
+
+static bool scenario_parse_line(struct scenario *s, char *line) {
+	const char *cmd = strtok(line, " \t\r\n");
+	if (cmd == NULL || cmd[0] == '#')
+		return true;
+
+	const char *arg = strtok(NULL, " \t\r\n");
+
+	if (strcmp(cmd, "state") == 0) {
+		s->state = scenario_find_name(state_names, SDL_arraysize(state_names), arg);
+		return s->state >= 0;
+	} else if (strcmp(cmd, "score") == 0)
+		return scenario_parse_count(arg, &s->score);
+	else if (strcmp(cmd, "seed") == 0) {
+		size_t seed;
+		if (!scenario_parse_count(arg, &seed))
+			return false;
+
+		/* xorshift never leaves zero */
+		s->seed = seed != 0? seed : 1;
+		return true;
+	} else if (strcmp(cmd, "dir") == 0) {
+		int dir = scenario_find_name(dir_names, SDL_arraysize(dir_names), arg);
+		s->dir  = dir;
+		return dir >= 0;
+	} else if (strcmp(cmd, "timer") == 0) {
+		int timer = scenario_find_name(timer_names, SDL_arraysize(timer_names), arg);
+		if (timer < 0)
+			return false;
+
+		s->timers |= (uint32_t)1 << timer;
+		return true;
+	} else if (strcmp(cmd, "particles") == 0) {
+		const char *count = strtok(NULL, " \t\r\n");
+		if (arg != NULL && strcmp(arg, "snake") == 0)
+			return scenario_parse_count(count, &s->snake_particles);
+		else if (arg != NULL && strcmp(arg, "cheese") == 0)
+			return scenario_parse_count(count, &s->cheese_particles);
+
+		return false;
+	} else if (strcmp(cmd, "snake") == 0) {
+		if (arg != NULL && strcmp(arg, "coil") == 0) {
+			size_t len;
+			if (!scenario_parse_count(strtok(NULL, " \t\r\n"), &len) || !scenario_coil(s, len))
+				return false;
+
+			scenario_face(s);
+			return true;
+		}
+
+		for (; arg != NULL; arg = strtok(NULL, " \t\r\n")) {
+			SDL_Point p;
+			if (!scenario_parse_point(arg, &p) || !scenario_add_snake(s, p))
+				return false;
+		}
+
+		scenario_face(s);
+		return true;
+	} else if (strcmp(cmd, "cheese") == 0) {
+		if (arg != NULL && strcmp(arg, "fill") == 0) {
+			scenario_fill_cheese(s);
+			return true;
+		} else if (arg != NULL && strcmp(arg, "random") == 0) {
+			size_t count;
+			return scenario_parse_count(strtok(NULL, " \t\r\n"), &count) &&
+			       scenario_random_cheese(s, count);
+		}
+
+		for (; arg != NULL; arg = strtok(NULL, " \t\r\n")) {
+			SDL_Point p;
+			if (!scenario_parse_point(arg, &p) || !scenario_add_cheese(s, p))
+				return false;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+bool scenario_load(struct scenario *s, const char *path) {
+	memset(s, 0, sizeof(*s));
+	s->state = STATE_GAMEPLAY;
+	s->seed  = 1;
+	s->dir   = RIGHT;
+
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		SDL_Log("Could not open the scenario '%s'", path);
+		return false;
+	}
+
+	char line[SCENARIO_LINE_SIZE];
+	bool ok = true;
+	for (int number = 1; ok && fgets(line, sizeof(line), f) != NULL; ++ number) {
+		if (!scenario_parse_line(s, line)) {
+			SDL_Log("%s:%i: Invalid scenario line", path, number);
+			ok = false;
+		}
+	}
+
+	fclose(f);
+
+	if (ok && s->len == 1) {
+		SDL_Log("%s: The snake needs at least two cells", path);
+		ok = false;
+	}
+
+	return ok;
+}
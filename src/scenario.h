@@ -0,0 +1,53 @@
+#ifndef SCENARIO_H_HEADER_GUARD
+#define SCENARIO_H_HEADER_GUARD
+
+#include <stdio.h>   /* FILE, fopen, fclose, fgets */
+#include <stdlib.h>  /* strtoul */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* memset, strcmp, strtok */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "snake.h"
+#include "cheese.h"
+#include "config.h"
+
+#define SCENARIO_LINE_SIZE 4096
+
+/* A board to start the game on instead of the usual one, read from a text file with a command per
+ * line and '#' comments:
+ *
+ *     state  tutorial | gameplay | paused | dead
+ *     score  N
+ *     seed   N                      also seeds everything random that happens once the game runs
+ *     snake  x,y x,y ...            cells from the head to the tail, may span several lines
+ *     snake  coil N                 N cells winding row by row from the top left, head last
+ *     dir    up | left | down | right
+ *     cheese x,y x,y ...
+ *     cheese fill | random N        every free cell, or N free cells picked from the seed
+ *     particles snake | cheese N
+ *     timer  shake | fade_in | fade_out | dead | transition
+ *
+ * The snake faces away from its second cell unless a dir follows it, and cheese that is generated
+ * only avoids the snake and cheese given above it. */
+struct scenario {
+	int      state;
+	size_t   score;
+	uint32_t seed;
+
+	SDL_Point body[MAX_SNAKE_LEN];
+	size_t    len;
+	enum dir  dir;
+
+	SDL_Point cheese[CHEESE_CAPACITY];
+	size_t    cheese_count;
+
+	size_t   snake_particles, cheese_particles;
+	uint32_t timers;
+};
+
+bool scenario_load(struct scenario *s, const char *path);
+
+#endif
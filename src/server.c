@@ -0,0 +1,498 @@
+#include "server.h"
+
+#ifdef __linux__
+
+/* What the epoll set hands back for everything that is not a session, past the last handle */
+enum {
+	SERVER_EVENT_LISTEN = SERVER_SESSIONS_CAPACITY,
+	SERVER_EVENT_TICK,
+	SERVER_EVENT_SIGNAL,
+};
+
+static void server_fail(const char *what) {
+	SDL_Log("Could not %s: %s", what, strerror(errno));
+	exit(EXIT_FAILURE);
+}
+
+/* xorshift32, every session gets its own so that sessions never share any state */
+static uint32_t session_rand(struct session *s) {
+	uint32_t x = s->rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return s->rng = x;
+}
+
+static bool session_on_snake(struct session *s, int x, int y) {
+	SDL_Point at = { .x = x, .y = y };
+	return snake_find(&s->snake, at, 0) < s->snake.len;
+}
+
+#define MAX_RETRIES 10
+
+static void session_spawn_cheese(struct session *s) {
+	for (int i = 0; i < MAX_RETRIES; ++ i) {
+		int x = session_rand(s) % COLS;
+		int y = session_rand(s) % ROWS;
+
+		if (s->cheese[y][x] || session_on_snake(s, x, y))
+			continue;
+
+		s->cheese[y][x] = true;
+		++ s->cheese_count;
+		s->dirty = true;
+		return;
+	}
+}
+
+static void session_restart(struct session *s) {
+	SDL_Point start = {
+		.x = 5,
+		.y = ROWS / 2,
+	};
+
+	/* There is no clock to show the tongue on */
+	snake_init(&s->snake, start, SNAKE_COLOR_EXPAND, NULL, 0);
+
+	memset(s->cheese, 0, sizeof(s->cheese));
+	s->cheese_count = 0;
+	s->tick         = 0;
+	s->score        = 0;
+	s->dirty        = true;
+}
+
+static void session_tick(struct session *s) {
+	if (s->snake.dead)
+		return;
+
+	++ s->tick;
+
+	SDL_Point at        = snake_head(&s->snake);
+	bool      on_cheese = s->cheese[at.y][at.x];
+
+	struct snake_step step;
+	snake_step(&s->snake, SNAKE_SPEED, on_cheese, &step);
+
+	if (step.ate) {
+		s->cheese[at.y][at.x] = false;
+		-- s->cheese_count;
+		++ s->score;
+	}
+
+	if (step.moved || step.died)
+		s->dirty = true;
+
+	if (s->tick % CHEESE_SPAWN_TICK_DELAY == 0)
+		session_spawn_cheese(s);
+}
+
+static void session_command(struct session *s, uint8_t cmd) {
+	if (cmd <= RIGHT) {
+		snake_change_dir(&s->snake, (enum dir)cmd, 0);
+	} else if (cmd == SERVER_CMD_RESTART && s->snake.dead)
+		session_restart(s);
+}
+
+static uint8_t *put_u16(uint8_t *at, uint16_t x) {
+	at[0] = x;
+	at[1] = x >> 8;
+	return at + 2;
+}
+
+static uint8_t *put_u32(uint8_t *at, uint32_t x) {
+	at = put_u16(at, x);
+	return put_u16(at, x >> 16);
+}
+
+static size_t session_pack(struct session *s, uint8_t *buf) {
+	uint8_t *at = buf;
+	at = put_u32(at, s->tick);
+	at = put_u16(at, s->score);
+	*at ++ = s->snake.dead? SERVER_FLAG_DEAD : 0;
+	*at ++ = s->snake.dir;
+	at = put_u16(at, s->snake.len);
+	at = put_u16(at, s->cheese_count);
+
+	SDL_Point cells[MAX_SNAKE_LEN];
+	snake_cells(&s->snake, cells);
+	for (size_t i = 0; i < s->snake.len; ++ i) {
+		*at ++ = (int8_t)cells[i].x;
+		*at ++ = (int8_t)cells[i].y;
+	}
+
+	for (int y = 0; y < ROWS; ++ y) {
+		for (int x = 0; x < COLS; ++ x) {
+			if (s->cheese[y][x]) {
+				*at ++ = x;
+				*at ++ = y;
+			}
+		}
+	}
+
+	return at - buf;
+}
+
+/* A client that is not reading keeps its session dirty, and gets whatever is latest once there is
+ * room in its socket again */
+static void server_send_update(struct server *srv, struct session *s) {
+	uint8_t buf[SERVER_UPDATE_MAX];
+	size_t  size = session_pack(s, buf);
+
+	if (send(s->fd, buf, size, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+		++ srv->dropped_updates;
+		return;
+	}
+
+	s->dirty = false;
+	++ srv->updates;
+}
+
+static void server_watch(struct server *srv, int fd, uint64_t data) {
+	struct epoll_event event = {
+		.events   = EPOLLIN,
+		.data.u64 = data,
+	};
+
+	if (epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+		server_fail("watch a file descriptor");
+}
+
+/* Every session takes a descriptor, so the soft limit is raised as far as the hard one allows,
+ * and the capacity shrinks to whatever still does not fit */
+static size_t server_capacity(void) {
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) < 0)
+		server_fail("get the open files limit");
+
+	rlim_t needed = SERVER_SESSIONS_CAPACITY + SERVER_RESERVED_FDS;
+	if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+		limit.rlim_cur = limit.rlim_max == RLIM_INFINITY || limit.rlim_max > needed?
+		                 needed : limit.rlim_max;
+		if (setrlimit(RLIMIT_NOFILE, &limit) < 0)
+			server_fail("raise the open files limit");
+	}
+
+	if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+		if (limit.rlim_cur <= SERVER_RESERVED_FDS) {
+			SDL_Log("The open files limit of %llu leaves no room for any sessions",
+			        (unsigned long long)limit.rlim_cur);
+			exit(EXIT_FAILURE);
+		}
+
+		return limit.rlim_cur - SERVER_RESERVED_FDS;
+	}
+
+	return SERVER_SESSIONS_CAPACITY;
+}
+
+/* A socket left behind by a server that did not get to clean up is removed, but not one that a
+ * server still listens on, or anything that is not a socket at all */
+static void server_claim_path(const struct sockaddr_un *addr) {
+	struct stat st;
+	if (lstat(addr->sun_path, &st) < 0) {
+		if (errno != ENOENT)
+			server_fail("look at the socket path");
+		return;
+	}
+
+	if (!S_ISSOCK(st.st_mode)) {
+		SDL_Log("Could not bind the socket: address in use, '%s' is not a socket", addr->sun_path);
+		exit(EXIT_FAILURE);
+	}
+
+	int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		server_fail("create the socket");
+
+	bool live = connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+	close(fd);
+	if (live) {
+		SDL_Log("Could not bind the socket: address in use, a server is running on '%s'",
+		        addr->sun_path);
+		exit(EXIT_FAILURE);
+	}
+
+	unlink(addr->sun_path);
+}
+
+void server_init(struct server *srv, const char *path) {
+	memset(srv, 0, sizeof(*srv));
+	srv->path     = path;
+	srv->seed     = SDL_GetPerformanceCounter();
+	srv->capacity = server_capacity();
+
+	srv->get = (struct session*)malloc(sizeof(*srv->get) * srv->capacity);
+	if (srv->get == NULL)
+		UNREACHABLE("malloc() fail");
+
+	/* Hand out the low handles first */
+	srv->free_count = srv->capacity;
+	for (size_t i = 0; i < srv->capacity; ++ i)
+		srv->free_handles[i] = srv->capacity - 1 - i;
+	for (size_t i = 0; i < SERVER_SESSIONS_CAPACITY; ++ i)
+		srv->index[i] = SESSION_NONE;
+
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		SDL_Log("Socket path '%s' is too long", path);
+		exit(EXIT_FAILURE);
+	}
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	server_claim_path(&addr);
+
+	srv->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (srv->spare_fd < 0)
+		server_fail("open the spare descriptor");
+
+	srv->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (srv->listen_fd < 0)
+		server_fail("create the socket");
+
+	if (bind(srv->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+		server_fail("bind the socket");
+
+	if (listen(srv->listen_fd, SERVER_BACKLOG) < 0)
+		server_fail("listen on the socket");
+
+	srv->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (srv->timer_fd < 0)
+		server_fail("create the tick timer");
+
+	struct itimerspec interval = {
+		.it_interval.tv_nsec = 1000000000 / TICK_RATE,
+		.it_value.tv_nsec    = 1000000000 / TICK_RATE,
+	};
+	if (timerfd_settime(srv->timer_fd, 0, &interval, NULL) < 0)
+		server_fail("start the tick timer");
+
+	/* Quitting goes through the event loop, so that the socket gets cleaned up */
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	if (sigprocmask(SIG_BLOCK, &signals, NULL) < 0)
+		server_fail("block the signals");
+
+	srv->signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (srv->signal_fd < 0)
+		server_fail("create the signal descriptor");
+
+	srv->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (srv->epoll_fd < 0)
+		server_fail("create the epoll set");
+
+	server_watch(srv, srv->listen_fd, SERVER_EVENT_LISTEN);
+	server_watch(srv, srv->timer_fd,  SERVER_EVENT_TICK);
+	server_watch(srv, srv->signal_fd, SERVER_EVENT_SIGNAL);
+
+	SDL_Log("Serving up to %zu sessions on '%s', %zu bytes each", srv->capacity, path,
+	        sizeof(struct session));
+}
+
+/* Closing the connection right after accepting it is how it gets turned away, the client sees
+ * the socket hang up before the first update */
+static void server_refuse(struct server *srv, int fd) {
+	close(fd);
+	if (srv->sessions_refused ++ == 0)
+		SDL_Log("Turning connections away, there is no room for more sessions");
+}
+
+static void server_open_session(struct server *srv, int fd) {
+	if (srv->free_count == 0) {
+		server_refuse(srv, fd);
+		return;
+	}
+
+	size_t handle = srv->free_handles[-- srv->free_count];
+
+	struct session *s = &srv->get[srv->count];
+	s->fd     = fd;
+	s->handle = handle;
+	s->rng    = srv->seed + (uint32_t)srv->sessions_served * 0x9e3779b9;
+	if (s->rng == 0)
+		s->rng = 1;
+	session_restart(s);
+
+	srv->index[handle] = srv->count ++;
+	server_watch(srv, fd, handle);
+
+	++ srv->sessions_served;
+	if (srv->count > srv->max_sessions)
+		srv->max_sessions = srv->count;
+
+	server_send_update(srv, s);
+}
+
+/* Closing the descriptor takes it out of the epoll set as well */
+static void server_close_session(struct server *srv, size_t handle) {
+	size_t i    = srv->index[handle];
+	size_t last = -- srv->count;
+	close(srv->get[i].fd);
+
+	if (i != last) {
+		srv->get[i] = srv->get[last];
+		srv->index[srv->get[i].handle] = i;
+	}
+
+	srv->index[handle] = SESSION_NONE;
+	srv->free_handles[srv->free_count ++] = handle;
+
+	/* Taking the spare back if it could not be reopened while the process was out of them */
+	if (srv->spare_fd < 0)
+		srv->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+/* Out of descriptors, the spare one makes room to accept a single connection and turn it away.
+ * Returns false if even that did not work, or there was nothing left to accept. */
+static bool server_refuse_spare(struct server *srv) {
+	close(srv->spare_fd);
+
+	int fd = accept(srv->listen_fd, NULL, NULL);
+	if (fd >= 0)
+		server_refuse(srv, fd);
+
+	srv->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	return fd >= 0 && srv->spare_fd >= 0;
+}
+
+/* Sessions never block on their sockets since every call passes MSG_DONTWAIT. The listening
+ * socket is level triggered, so the backlog is always drained, even when nothing fits. */
+static void server_accept(struct server *srv) {
+	for (;;) {
+		int fd = accept(srv->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if ((errno == EMFILE || errno == ENFILE) && srv->spare_fd >= 0) {
+				if (server_refuse_spare(srv))
+					continue;
+				return;
+			}
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				SDL_Log("Could not accept a connection: %s", strerror(errno));
+			return;
+		}
+
+		server_open_session(srv, fd);
+	}
+}
+
+static void server_read(struct server *srv, size_t handle) {
+	/* Events that were already waiting can still come in for a session that was closed */
+	if (srv->index[handle] == SESSION_NONE)
+		return;
+
+	struct session *s = &srv->get[srv->index[handle]];
+	for (;;) {
+		uint8_t buf[64];
+		ssize_t size = recv(s->fd, buf, sizeof(buf), MSG_DONTWAIT);
+		if (size < 0 && errno == EINTR)
+			continue;
+
+		if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+
+		if (size <= 0) {
+			server_close_session(srv, handle);
+			return;
+		}
+
+		for (ssize_t i = 0; i < size; ++ i)
+			session_command(s, buf[i]);
+	}
+}
+
+/* Every session moves on by however many ticks went by, up to MAX_CATCH_UP, and only then do the
+ * updates go out, so a client never gets more than one of them per wakeup */
+static void server_tick(struct server *srv) {
+	uint64_t expired;
+	if (read(srv->timer_fd, &expired, sizeof(expired)) != sizeof(expired))
+		return;
+
+	Uint64 start = trace_begin();
+
+	if (expired > MAX_CATCH_UP) {
+		srv->late_ticks += expired - MAX_CATCH_UP;
+		expired = MAX_CATCH_UP;
+	}
+
+	for (uint64_t t = 0; t < expired; ++ t) {
+		for (size_t i = 0; i < srv->count; ++ i)
+			session_tick(&srv->get[i]);
+	}
+	srv->ticks += expired;
+
+	for (size_t i = 0; i < srv->count; ++ i) {
+		if (srv->get[i].dirty)
+			server_send_update(srv, &srv->get[i]);
+	}
+
+	trace_end("server_tick", start);
+}
+
+void server_run(struct server *srv) {
+	struct epoll_event events[SERVER_EVENTS];
+
+	while (!srv->quit) {
+		int count = epoll_wait(srv->epoll_fd, events, SERVER_EVENTS, -1);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+
+			server_fail("wait for events");
+		}
+
+		for (int i = 0; i < count; ++ i) {
+			uint64_t data = events[i].data.u64;
+			switch (data) {
+			case SERVER_EVENT_LISTEN: server_accept(srv); break;
+			case SERVER_EVENT_TICK:   server_tick(srv);   break;
+			case SERVER_EVENT_SIGNAL: srv->quit = true;   break;
+			default:                  server_read(srv, data);
+			}
+		}
+	}
+}
+
+void server_finish(struct server *srv) {
+	while (srv->count > 0)
+		server_close_session(srv, srv->get[0].handle);
+
+	close(srv->epoll_fd);
+	close(srv->signal_fd);
+	close(srv->timer_fd);
+	close(srv->listen_fd);
+	if (srv->spare_fd >= 0)
+		close(srv->spare_fd);
+	unlink(srv->path);
+	free(srv->get);
+
+	SDL_Log("Served %zu sessions, up to %zu at once, turned %zu away", srv->sessions_served,
+	        srv->max_sessions, srv->sessions_refused);
+	SDL_Log("Ran %llu ticks, %llu more were skipped to catch up", (unsigned long long)srv->ticks,
+	        (unsigned long long)srv->late_ticks);
+	SDL_Log("Sent %llu updates, %llu did not fit into a client's socket",
+	        (unsigned long long)srv->updates, (unsigned long long)srv->dropped_updates);
+}
+
+#else
+
+/* epoll, timerfd and signalfd are only there on Linux */
+void server_init(struct server *srv, const char *path) {
+	UNUSED(srv);
+	SDL_Log("Cannot serve on '%s', the server only runs on Linux", path);
+	exit(EXIT_FAILURE);
+}
+
+void server_run(struct server *srv) {
+	UNUSED(srv);
+}
+
+void server_finish(struct server *srv) {
+	UNUSED(srv);
+}
+
+#endif
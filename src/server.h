@@ -0,0 +1,110 @@
+#ifndef SERVER_H_HEADER_GUARD
+#define SERVER_H_HEADER_GUARD
+
+#include <stdlib.h>  /* exit, EXIT_FAILURE, malloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint8_t, int8_t, uint16_t, uint32_t, uint64_t */
+#include <string.h>  /* memset, strlen, strncpy, strerror */
+#include <assert.h>  /* static_assert */
+
+#ifdef __linux__
+#	include <errno.h>        /* errno, EAGAIN, EWOULDBLOCK, EINTR, EMFILE, ENFILE, ENOENT */
+#	include <signal.h>       /* sigset_t, sigemptyset, sigaddset, sigprocmask, SIGINT, SIGTERM */
+#	include <fcntl.h>        /* open, O_RDONLY, O_CLOEXEC */
+#	include <unistd.h>       /* ssize_t, read, close, unlink */
+#	include <sys/stat.h>     /* lstat, stat, S_ISSOCK */
+#	include <sys/resource.h> /* getrlimit, setrlimit, rlimit, RLIMIT_NOFILE */
+#	include <sys/socket.h>   /* socket, bind, connect, listen, accept, recv, send */
+#	include <sys/un.h>       /* sockaddr_un */
+#	include <sys/epoll.h>    /* epoll_create1, epoll_ctl, epoll_wait */
+#	include <sys/timerfd.h>  /* timerfd_create, timerfd_settime */
+#	include <sys/signalfd.h> /* signalfd, signalfd_siginfo */
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "trace.h"
+#include "snake.h"
+#include "config.h"
+
+/* Clients connect to a SOCK_SEQPACKET Unix socket, and every connection plays a game of its own.
+ *
+ * A client sends messages of single byte commands: a direction (UP, LEFT, DOWN or RIGHT) turns
+ * the snake, SERVER_CMD_RESTART starts over once it is dead.
+ *
+ * The server sends the whole board in one message, on connecting and whenever it changed since
+ * the last one. Numbers are little endian:
+ *
+ *     uint32_t tick
+ *     uint16_t score
+ *     uint8_t  flags      SERVER_FLAG_*
+ *     uint8_t  dir
+ *     uint16_t len
+ *     uint16_t cheese_count
+ *     int8_t   body[len][2]           x, y, the head first
+ *     int8_t   cheese[cheese_count][2]
+ */
+
+enum {
+	SERVER_CMD_RESTART = RIGHT + 1,
+};
+
+enum {
+	SERVER_FLAG_DEAD = 1 << 0,
+};
+
+#define SERVER_UPDATE_HEADER 12
+#define SERVER_UPDATE_MAX    (SERVER_UPDATE_HEADER + (MAX_SNAKE_LEN + ROWS * COLS) * 2)
+
+/* The head can be one cell off the map once the snake died */
+static_assert(COLS < 127 && ROWS < 127, "Cells have to fit into an int8_t");
+
+#define SESSION_NONE ((size_t)-1)
+
+/* A game without anything to show it with, just the board and the connection playing on it */
+struct session {
+	int    fd;
+	size_t handle;
+
+	struct snake snake;
+	bool         cheese[ROWS][COLS];
+	size_t       cheese_count;
+
+	uint32_t tick, score;
+	uint32_t rng;
+
+	/* Set whenever there is something new to send */
+	bool dirty;
+};
+
+/* Sessions are kept packed in get[0 .. count - 1] so that a tick walks through them in order, with
+ * handles that stay the same for as long as the connection is open, like in the cheese pool. The
+ * listening socket, the tick timer and the signals all wait in the same epoll set. */
+struct server {
+	const char *path;
+	int         listen_fd, epoll_fd, timer_fd, signal_fd;
+	bool        quit;
+	uint32_t    seed;
+
+	/* Held open only to be closed again when the process runs out of descriptors, so that there
+	 * is one to accept the waiting connection with and turn it away, instead of leaving it in the
+	 * backlog where it keeps the listening socket readable */
+	int spare_fd;
+
+	struct session *get;
+	size_t          count, capacity;
+
+	size_t index[SERVER_SESSIONS_CAPACITY];
+	size_t free_handles[SERVER_SESSIONS_CAPACITY];
+	size_t free_count;
+
+	uint64_t ticks, late_ticks, updates, dropped_updates;
+	size_t   sessions_served, max_sessions, sessions_refused;
+};
+
+void server_init(struct server *s, const char *path);
+void server_run(struct server *s);
+void server_finish(struct server *s);
+
+#endif
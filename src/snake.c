@@ -20,89 +20,265 @@ double dir_to_angle(enum dir dir) {
 	}
 }
 
-static void snake_delay_tongue(struct snake *s) {
+static SDL_Point dir_offset(enum dir dir) {
+	switch (dir) {
+	case UP:    return (SDL_Point){ .x =  0, .y = -1 };
+	case LEFT:  return (SDL_Point){ .x = -1, .y =  0 };
+	case DOWN:  return (SDL_Point){ .x =  0, .y =  1 };
+	case RIGHT: return (SDL_Point){ .x =  1, .y =  0 };
+
+	default: UNREACHABLE("Impossible direction");
+	}
+
+	return (SDL_Point){0};
+}
+
+static struct snake_segment *snake_segment(struct snake *s, size_t i) {
+	return &s->segments[(s->segments_start + i) % MAX_SNAKE_LEN];
+}
+
+/* The i-th cell of a segment, counted from its head end */
+static SDL_Point snake_segment_cell(struct snake_segment *seg, size_t i) {
+	SDL_Point d = dir_offset(seg->dir);
+	return (SDL_Point){ .x = seg->x - d.x * (int)i, .y = seg->y - d.y * (int)i };
+}
+
+static void snake_push_tail(struct snake *s, SDL_Point at, enum dir dir) {
+	struct snake_segment *seg = snake_segment(s, s->segments_count ++);
+	seg->x   = at.x;
+	seg->y   = at.y;
+	seg->len = 1;
+	seg->dir = dir;
+}
+
+/* Drops count cells off the end of the tail, whole segments at a time where it can */
+static void snake_pop_tail(struct snake *s, size_t count) {
+	while (count > 0) {
+		struct snake_segment *tail = snake_segment(s, s->segments_count - 1);
+		if (tail->len > count) {
+			tail->len -= count;
+			break;
+		}
+
+		count -= tail->len;
+		-- s->segments_count;
+	}
+}
+
+static void snake_start_tongue(struct snake *s, struct timer_wheel *clock,
+                               enum tongue_state state, size_t time) {
+	s->tongue_state = state;
+	timer_set(&s->tongue_timer, time);
+	timer_start(&s->tongue_timer, clock);
+}
+
+static void snake_delay_tongue(struct snake *s, struct timer_wheel *clock) {
 	size_t total = SNAKE_TONGUE_MOVE_TIME * 2 + SNAKE_TONGUE_TIME;
 	size_t time  = rand_irange(SNAKE_TONGUE_MIN_DELAY, SNAKE_TONGUE_MAX_DELAY + total);
 
-	s->tongue_state = TONGUE_HIDDEN;
-	timer_init(&s->tongue_timer, time);
-	timer_start(&s->tongue_timer);
+	snake_start_tongue(s, clock, TONGUE_HIDDEN, time);
 }
 
-void snake_init(struct snake *s, SDL_Point start,
-                struct snake_textures textures, int r, int g, int b) {
+void snake_init(struct snake *s, SDL_Point start, int r, int g, int b,
+                struct timer_wheel *clock, int tongue_event) {
 	memset(s, 0, sizeof(*s));
 
-	s->head     = s->body;
-	s->len      = 2;
-	s->offset   = 1;
-	s->dir      = RIGHT;
-	s->next_dir = s->dir;
+	s->offset = 1;
+	s->dir    = RIGHT;
 
-	s->head->x   = start.x;
-	s->head->y   = start.y;
-	s->body[1].x = start.x - 1;
-	s->body[1].y = start.y;
-	s->prev.x    = start.x - 2;
-	s->prev.y    = start.y;
+	SDL_Point body[] = {start, { .x = start.x - 1, .y = start.y }};
+	snake_set_body(s, body, SDL_arraysize(body));
 
-	snake_delay_tongue(s);
+	s->prev.x = start.x - 2;
+	s->prev.y = start.y;
+
+	/* Without a clock, there is nobody to show the tongue to */
+	timer_init(&s->tongue_timer, 0, tongue_event);
+	if (clock != NULL)
+		snake_delay_tongue(s, clock);
 
-	s->textures = textures;
 	s->r = r;
 	s->g = g;
 	s->b = b;
 }
 
-void snake_update(struct snake *s) {
-	timer_update(&s->tongue_timer);
-	if (timer_just_ended(&s->tongue_timer)) {
-		switch (s->tongue_state) {
-		case TONGUE_SHOWING:
-			s->tongue_state = TONGUE_SHOWN;
-			timer_init(&s->tongue_timer, SNAKE_TONGUE_TIME);
-			timer_start(&s->tongue_timer);
+/* Called whenever the tongue timer fires, moves the tongue on to its next state */
+void snake_update_tongue(struct snake *s, struct timer_wheel *clock) {
+	switch (s->tongue_state) {
+	case TONGUE_SHOWING: snake_start_tongue(s, clock, TONGUE_SHOWN,   SNAKE_TONGUE_TIME);      break;
+	case TONGUE_SHOWN:   snake_start_tongue(s, clock, TONGUE_HIDING,  SNAKE_TONGUE_MOVE_TIME); break;
+	case TONGUE_HIDING:  snake_delay_tongue(s, clock);                                         break;
+	case TONGUE_HIDDEN:  snake_start_tongue(s, clock, TONGUE_SHOWING, SNAKE_TONGUE_MOVE_TIME); break;
+	}
+}
 
-			break;
+/* Replaces the body with the given cells, from the head to the tail. Every cell has to be next to
+ * the one before it. */
+void snake_set_body(struct snake *s, const SDL_Point *cells, size_t len) {
+	s->segments_start = 0;
+	s->segments_count = 0;
+	s->len            = len;
+
+	for (size_t i = 0; i < len; ++ i) {
+		/* The tail always continues the segment it is in */
+		struct snake_segment *last = s->segments_count > 0?
+		                             snake_segment(s, s->segments_count - 1) : NULL;
+		enum dir dir = i + 1 < len? dir_from_a_to_b(cells[i + 1], cells[i]) :
+		               last != NULL? (enum dir)last->dir : s->dir;
+
+		if (last != NULL && last->dir == dir)
+			++ last->len;
+		else
+			snake_push_tail(s, cells[i], dir);
+	}
+}
 
-		case TONGUE_SHOWN:
-			s->tongue_state = TONGUE_HIDING;
-			timer_init(&s->tongue_timer, SNAKE_TONGUE_MOVE_TIME);
-			timer_start(&s->tongue_timer);
+SDL_Point snake_head(struct snake *s) {
+	struct snake_segment *head = snake_segment(s, 0);
+	return (SDL_Point){ .x = head->x, .y = head->y };
+}
 
-			break;
+SDL_Point snake_tail(struct snake *s) {
+	struct snake_segment *tail = snake_segment(s, s->segments_count - 1);
+	return snake_segment_cell(tail, tail->len - 1);
+}
 
-		case TONGUE_HIDING: snake_delay_tongue(s); break;
-		case TONGUE_HIDDEN:
-			s->tongue_state = TONGUE_SHOWING;
-			timer_init(&s->tongue_timer, SNAKE_TONGUE_MOVE_TIME);
-			timer_start(&s->tongue_timer);
+/* The first cell at or after from that is at the given position, len if there is none. Each
+ * segment is tested as a whole, since a straight run can only cross a cell once. */
+size_t snake_find(struct snake *s, SDL_Point at, size_t from) {
+	size_t index = 0;
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		struct snake_segment *seg = snake_segment(s, i);
+		SDL_Point             d   = dir_offset(seg->dir);
 
-			break;
+		int cell = -1;
+		if (d.x != 0 && at.y == seg->y)
+			cell = (seg->x - at.x) * d.x;
+		else if (d.y != 0 && at.x == seg->x)
+			cell = (seg->y - at.y) * d.y;
+
+		if (cell >= 0 && cell < seg->len && index + cell >= from)
+			return index + cell;
+
+		index += seg->len;
+	}
+
+	return s->len;
+}
+
+/* Writes out every cell of the body, from the head to the tail */
+void snake_cells(struct snake *s, SDL_Point *cells) {
+	size_t index = 0;
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		struct snake_segment *seg = snake_segment(s, i);
+		for (size_t j = 0; j < seg->len; ++ j)
+			cells[index ++] = snake_segment_cell(seg, j);
+	}
+}
+
+static bool snake_cell_on_map(SDL_Point at) {
+	return at.x >= 0 && at.x < COLS && at.y >= 0 && at.y < ROWS;
+}
+
+/* For a snake that comes from outside, like a save. The rings, the segments and the turns have to
+ * hold together, and only the head of a dead snake can be off the map, by a single cell. */
+bool snake_valid(struct snake *s) {
+	if (s->len == 0 || s->len > MAX_SNAKE_LEN || s->segments_start >= MAX_SNAKE_LEN ||
+	    s->segments_count == 0 || s->segments_count > s->len)
+		return false;
+
+	if ((unsigned)s->dir > RIGHT || (unsigned)s->tongue_state > TONGUE_HIDING ||
+	    !(s->offset >= 0 && s->offset <= 1))
+		return false;
+
+	if (s->turns_start >= SNAKE_TURNS_CAPACITY || s->turns_count > SNAKE_TURNS_CAPACITY)
+		return false;
+
+	for (size_t i = 0; i < s->turns_count; ++ i) {
+		if ((unsigned)s->turns[(s->turns_start + i) % SNAKE_TURNS_CAPACITY].dir > RIGHT)
+			return false;
+	}
+
+	SDL_Point head = snake_head(s);
+	if (!snake_cell_on_map(head) && !(s->dead && head.x >= -1 && head.x <= COLS &&
+	                                                head.y >= -1 && head.y <= ROWS))
+		return false;
+
+	size_t len = 0;
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		struct snake_segment *seg = snake_segment(s, i);
+		if (seg->len == 0 || seg->dir > RIGHT || seg->len > s->len - len)
+			return false;
+
+		/* Every segment starts right behind the end of the one before it */
+		if (i > 0) {
+			struct snake_segment *before = snake_segment(s, i - 1);
+			SDL_Point             behind = snake_segment_cell(before, before->len);
+			if (seg->x != behind.x || seg->y != behind.y)
+				return false;
 		}
+
+		/* Segments are straight, so both of their ends being on the map is enough */
+		size_t first = i == 0? 1 : 0;
+		if (first < seg->len && (!snake_cell_on_map(snake_segment_cell(seg, first)) ||
+		                         !snake_cell_on_map(snake_segment_cell(seg, seg->len - 1))))
+			return false;
+
+		len += seg->len;
 	}
+
+	return len == s->len;
 }
 
 bool snake_move(struct snake *s, float by) {
+	/* Whatever is left over past the next cell is kept, for the next one */
 	s->offset += by;
 	if (s->offset >= 1) {
-		s->offset = 0;
-		s->dir  = s->next_dir;
-		s->prev = s->body[s->len - 1];
+		s->offset   -= 1;
+		s->prev      = snake_tail(s);
+		s->turned_at = 0;
 
-		for (; s->requested_grow > 0; -- s->requested_grow) {
-			s->body[s->len] = s->body[s->len - 1];
-			++ s->len;
+		if (s->turns_count > 0) {
+			struct turn *turn = &s->turns[s->turns_start];
+			s->dir       = turn->dir;
+			s->turned_at = turn->timestamp;
+
+			s->turns_start = (s->turns_start + 1) % SNAKE_TURNS_CAPACITY;
+			-- s->turns_count;
 		}
 
-		for (size_t i = s->len - 1; i > 0; -- i)
-			s->body[i] = s->body[i - 1];
+		SDL_Point d  = dir_offset(s->dir);
+		SDL_Point at = snake_head(s);
+		at.x += d.x;
+		at.y += d.y;
 
-		switch (s->dir) {
-		case UP:    -- s->head->y; break;
-		case LEFT:  -- s->head->x; break;
-		case DOWN:  ++ s->head->y; break;
-		case RIGHT: ++ s->head->x; break;
+		/* A growing snake leaves its tail where it is for one move per cell it grows by, a snake at
+		 * full length just stops growing. The tail goes first, so that the ring never holds more
+		 * segments than there are cells. */
+		if (s->requested_grow > 0 && s->len >= MAX_SNAKE_LEN)
+			s->requested_grow = 0;
+
+		if (s->requested_grow > 0) {
+			-- s->requested_grow;
+			++ s->len;
+		} else
+			snake_pop_tail(s, 1);
+
+		/* Going straight on only moves the head end of the first segment, turning starts a new one */
+		struct snake_segment *head = snake_segment(s, 0);
+		if (s->segments_count > 0 && head->dir == s->dir) {
+			head->x = at.x;
+			head->y = at.y;
+			++ head->len;
+		} else {
+			s->segments_start = (s->segments_start + MAX_SNAKE_LEN - 1) % MAX_SNAKE_LEN;
+			++ s->segments_count;
+
+			head      = snake_segment(s, 0);
+			head->x   = at.x;
+			head->y   = at.y;
+			head->len = 1;
+			head->dir = s->dir;
 		}
 
 		return true;
@@ -110,6 +286,37 @@ bool snake_move(struct snake *s, float by) {
 		return false;
 }
 
+bool snake_will_move(struct snake *s, float by) {
+	return s->offset + by >= 1;
+}
+
+/* Moves the snake and resolves what it ran into. It touches nothing but the snake, no sound, no
+ * particles and no global state, so that it can run just as well on copies of it. */
+void snake_step(struct snake *s, float by, bool on_cheese, struct snake_step *step) {
+	memset(step, 0, sizeof(*step));
+	step->from  = snake_head(s);
+	step->moved = snake_move(s, by);
+
+	/* The cheese under the head is eaten once the head leaves its cell */
+	if (step->moved && on_cheese) {
+		snake_grow(s);
+		step->ate = true;
+	}
+
+	SDL_Point head   = snake_head(s);
+	size_t    bit_at = snake_find(s, head, 1);
+	if (bit_at < s->len) {
+		step->bit_at = bit_at;
+		step->bite   = head;
+		snake_shrink_to(s, bit_at);
+	}
+
+	if (head.x < 0 || head.x >= COLS || head.y < 0 || head.y >= ROWS) {
+		s->dead    = true;
+		step->died = true;
+	}
+}
+
 void snake_grow(struct snake *s) {
 	++ s->requested_grow;
 }
@@ -118,15 +325,44 @@ void snake_shrink_to(struct snake *s, size_t len) {
 	if (len >= s->len)
 		UNREACHABLE("Invalid shrink");
 
-	s->len  = len;
-	s->prev = s->body[len];
+	/* The first cell that is cut off is the one the new tail just left */
+	size_t index = 0;
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		struct snake_segment *seg = snake_segment(s, i);
+		if (len < index + seg->len) {
+			s->prev = snake_segment_cell(seg, len - index);
+			break;
+		}
+
+		index += seg->len;
+	}
+
+	snake_pop_tail(s, s->len - len);
+	s->len = len;
 }
 
-void snake_change_dir(struct snake *s, enum dir dir) {
-	if ((s->dir - dir) % 2 == 0)
-		return;
+enum dir snake_next_dir(struct snake *s) {
+	if (s->turns_count == 0)
+		return s->dir;
+
+	return s->turns[(s->turns_start + s->turns_count - 1) % SNAKE_TURNS_CAPACITY].dir;
+}
+
+bool snake_change_dir(struct snake *s, enum dir dir, Uint32 timestamp) {
+	/* Checked against the direction the snake will be going in once all the queued turns were
+	 * taken, not the one it is going in right now */
+	if ((snake_next_dir(s) - dir) % 2 == 0)
+		return false;
+
+	if (s->turns_count >= SNAKE_TURNS_CAPACITY)
+		return false;
+
+	struct turn *turn = &s->turns[(s->turns_start + s->turns_count) % SNAKE_TURNS_CAPACITY];
+	turn->dir       = dir;
+	turn->timestamp = timestamp;
 
-	s->next_dir = dir;
+	++ s->turns_count;
+	return true;
 }
 
 static SDL_Rect snake_offset_part_rect(struct snake *s, SDL_Point pos, enum dir dir, bool inv) {
@@ -154,32 +390,44 @@ static SDL_Rect snake_offset_part_rect(struct snake *s, SDL_Point pos, enum dir
 	return r;
 }
 
-static void snake_render_shadow(struct snake *s, SDL_Rect front, SDL_Rect back, SDL_Renderer *ren) {
-	SDL_Rect r;
-	r.w = RECT_SIZE;
-	r.h = RECT_SIZE;
+/* Covers the cells of a segment from the skip-th one on with a single rectangle, false if that
+ * leaves nothing to cover */
+static bool snake_segment_rect(struct snake_segment *seg, size_t skip, SDL_Rect *r) {
+	if (skip >= seg->len)
+		return false;
 
-	SDL_SetRenderDrawColor(ren, 0, 0, 0, SHADOW_ALPHA);
+	SDL_Point a = snake_segment_cell(seg, skip), b = snake_segment_cell(seg, seg->len - 1);
+	r->x = (a.x < b.x? a.x : b.x) * RECT_SIZE;
+	r->y = (a.y < b.y? a.y : b.y) * RECT_SIZE;
+	r->w = (abs(a.x - b.x) + 1) * RECT_SIZE;
+	r->h = (abs(a.y - b.y) + 1) * RECT_SIZE;
+	return true;
+}
 
+static void snake_render_shadow(struct snake *s, SDL_Rect front, SDL_Rect back,
+                                struct render_queue *q) {
 	SDL_Rect front_shadow = front;
 	front_shadow.x += SHADOW_OFFSET;
 	front_shadow.y += SHADOW_OFFSET;
-	SDL_RenderFillRect(ren, &front_shadow);
+	render_queue_fill(q, LAYER_SNAKE_SHADOW, &front_shadow, 0, 0, 0, SHADOW_ALPHA);
 
-	if (s->prev.x != s->body[s->len - 1].x || s->prev.y != s->body[s->len - 1].y) {
+	SDL_Point tail = snake_tail(s);
+	if (s->prev.x != tail.x || s->prev.y != tail.y) {
 		SDL_Rect back_shadow = back;
 		back_shadow.x += SHADOW_OFFSET;
 		back_shadow.y += SHADOW_OFFSET;
-		SDL_RenderFillRect(ren, &back_shadow);
+		render_queue_fill(q, LAYER_SNAKE_SHADOW, &back_shadow, 0, 0, 0, SHADOW_ALPHA);
 	}
 
-	for (size_t i = 1; i < s->len; ++ i) {
-		if (s->body[i].x == s->body[i - 1].x && s->body[i].y == s->body[i - 1].y)
+	/* The head is drawn as the front */
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		SDL_Rect r;
+		if (!snake_segment_rect(snake_segment(s, i), i == 0, &r))
 			continue;
 
-		r.x = s->body[i].x * RECT_SIZE + SHADOW_OFFSET;
-		r.y = s->body[i].y * RECT_SIZE + SHADOW_OFFSET;
-		SDL_RenderFillRect(ren, &r);
+		r.x += SHADOW_OFFSET;
+		r.y += SHADOW_OFFSET;
+		render_queue_fill(q, LAYER_SNAKE_SHADOW, &r, 0, 0, 0, SHADOW_ALPHA);
 	}
 }
 
@@ -196,47 +444,49 @@ static void snake_fade_color(struct snake *s, size_t i, int *r, int *g, int *b)
 		*b = 0;
 }
 
-static void snake_render_body(struct snake *s, SDL_Rect front, SDL_Rect back, SDL_Renderer *ren) {
-	SDL_Rect r_;
-	r_.w = RECT_SIZE;
-	r_.h = RECT_SIZE;
-
-	SDL_SetRenderDrawColor(ren, s->r, s->g, s->b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(ren, &front);
+/* Every segment is filled at once, in the colour of the cell it starts with */
+static void snake_render_body(struct snake *s, SDL_Rect front, SDL_Rect back,
+                              struct render_queue *q) {
+	render_queue_fill(q, LAYER_SNAKE, &front, s->r, s->g, s->b, SDL_ALPHA_OPAQUE);
 
 	int r, g, b;
 	snake_fade_color(s, s->len, &r, &g, &b);
-	SDL_SetRenderDrawColor(ren, r, g, b, SDL_ALPHA_OPAQUE);
-	SDL_RenderFillRect(ren, &back);
+	render_queue_fill(q, LAYER_SNAKE, &back, r, g, b, SDL_ALPHA_OPAQUE);
 
-	for (size_t i = 1; i < s->len; ++ i) {
-		if (s->body[i].x == s->body[i - 1].x && s->body[i].y == s->body[i - 1].y)
-			continue;
+	size_t index = 0;
+	for (size_t i = 0; i < s->segments_count; ++ i) {
+		struct snake_segment *seg  = snake_segment(s, i);
+		size_t                skip = i == 0;
 
-		r_.x = s->body[i].x * RECT_SIZE;
-		r_.y = s->body[i].y * RECT_SIZE;
+		SDL_Rect rect;
+		if (snake_segment_rect(seg, skip, &rect)) {
+			snake_fade_color(s, index + skip, &r, &g, &b);
+			render_queue_fill(q, LAYER_SNAKE, &rect, r, g, b, SDL_ALPHA_OPAQUE);
+		}
 
-		snake_fade_color(s, i, &r, &g, &b);
-		SDL_SetRenderDrawColor(ren, r, g, b, SDL_ALPHA_OPAQUE);
-		SDL_RenderFillRect(ren, &r_);
+		index += seg->len;
 	}
 }
 
-static void snake_render_face(struct snake *s, SDL_Renderer *ren) {
+static void snake_render_face(struct snake *s, struct snake_textures *textures,
+                              struct render_queue *q, size_t now) {
 	int offset = s->offset * RECT_SIZE;
 
-	SDL_Rect eyes = {
+	SDL_Point head = snake_head(s);
+	SDL_Rect  eyes = {
 		.w = RECT_SIZE,
 		.h = RECT_SIZE,
-		.x = s->head->x * RECT_SIZE,
-		.y = s->head->y * RECT_SIZE,
+		.x = head.x * RECT_SIZE,
+		.y = head.y * RECT_SIZE,
 	};
 
-	int tongue_offset = timer_unit(&s->tongue_timer, s->tongue_state != TONGUE_HIDING) * RECT_SIZE;
+	int tongue_offset = timer_unit(&s->tongue_timer, now, s->tongue_state != TONGUE_HIDING) *
+	                    RECT_SIZE;
+	/* Only the part of the tongue that is already out is drawn */
 	SDL_Rect tongue = eyes, src = {
-		.x = 0,
-		.y = 0,
-		.w = RECT_SIZE,
+		.x = textures->tongue->src.x,
+		.y = textures->tongue->src.y,
+		.w = textures->tongue->src.w,
 		.h = tongue_offset,
 	};
 
@@ -267,20 +517,27 @@ static void snake_render_face(struct snake *s, SDL_Renderer *ren) {
 		break;
 	}
 
-	SDL_RenderCopyEx(ren, s->dead? s->textures.eyes_dead : s->textures.eyes,
-	                 NULL, &eyes, angle, NULL, SDL_FLIP_NONE);
+	struct texture *face = s->dead? textures->eyes_dead : textures->eyes;
+	render_queue_copy_ex(q, LAYER_SNAKE_FACE, face->sdl, &face->src, &eyes, angle,
+	                     SDL_ALPHA_OPAQUE);
 
 	if (s->tongue_state != TONGUE_HIDDEN)
-		SDL_RenderCopyEx(ren, s->textures.tongue, s->tongue_state == TONGUE_SHOWN? NULL : &src,
-		                 &tongue, angle, NULL, SDL_FLIP_NONE);
+		render_queue_copy_ex(q, LAYER_SNAKE_FACE, textures->tongue->sdl,
+		                     s->tongue_state == TONGUE_SHOWN? &textures->tongue->src : &src,
+		                     &tongue, angle, SDL_ALPHA_OPAQUE);
 }
 
-void snake_render(struct snake *s, SDL_Renderer *ren) {
-	enum dir dir = dir_from_a_to_b(s->body[s->len - 1], s->prev);
-	SDL_Rect front = snake_offset_part_rect(s, *s->head, s->dir, false);
+void snake_render(struct snake *s, struct snake_textures *textures, struct render_queue *q,
+                  size_t now) {
+	Uint64 start = trace_begin();
+
+	enum dir dir = dir_from_a_to_b(snake_tail(s), s->prev);
+	SDL_Rect front = snake_offset_part_rect(s, snake_head(s), s->dir, false);
 	SDL_Rect back  = snake_offset_part_rect(s, s->prev,  dir,    true);
 
-	snake_render_shadow(s, front, back, ren);
-	snake_render_body(s, front, back, ren);
-	snake_render_face(s, ren);
+	snake_render_shadow(s, front, back, q);
+	snake_render_body(s, front, back, q);
+	snake_render_face(s, textures, q, now);
+
+	trace_end("snake_render", start);
 }
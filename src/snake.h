@@ -2,11 +2,16 @@
 #define SNAKE_H_HEADER_GUARD
 
 #include <assert.h>  /* static_assert */
+#include <stdlib.h>  /* abs */
+#include <stdint.h>  /* int16_t, uint8_t, uint16_t */
 
 #include <SDL2/SDL.h>
 
 #include "common.h"
 #include "timer.h"
+#include "trace.h"
+#include "render_queue.h"
+#include "assets.h"
 #include "config.h"
 
 enum dir {
@@ -19,10 +24,10 @@ enum dir {
 enum dir dir_from_a_to_b(SDL_Point a, SDL_Point b);
 double   dir_to_angle(enum dir dir);
 
-#define MAX_SNAKE_LEN 256
+#define MAX_SNAKE_LEN (ROWS * COLS)
 
 struct snake_textures {
-	SDL_Texture *eyes, *eyes_dead, *tongue;
+	struct texture *eyes, *eyes_dead, *tongue;
 };
 
 #define SNAKE_TONGUE_TIME      30
@@ -33,6 +38,15 @@ struct snake_textures {
 
 static_assert(SNAKE_TONGUE_MAX_DELAY > SNAKE_TONGUE_MIN_DELAY, "");
 
+/* Turns are queued up and applied one per cell, so that pressing two keys quickly within a single
+ * cell still makes the snake take both turns */
+#define SNAKE_TURNS_CAPACITY 8
+
+struct turn {
+	enum dir dir;
+	Uint32   timestamp;
+};
+
 enum tongue_state {
 	TONGUE_HIDDEN = 0,
 	TONGUE_SHOWING,
@@ -40,32 +54,69 @@ enum tongue_state {
 	TONGUE_HIDING,
 };
 
+/* A straight run of the body, from its cell closest to the head back len cells against dir, the
+ * direction the snake was going in when it moved into them */
+struct snake_segment {
+	int16_t  x, y;
+	uint16_t len;
+	uint8_t  dir;
+};
+
+static_assert(MAX_SNAKE_LEN <= UINT16_MAX, "Segments have to fit the whole snake");
+
 struct snake {
-	SDL_Point  body[MAX_SNAKE_LEN];
-	SDL_Point *head;
-	SDL_Point  prev;
+	/* The body is stored as segments between the turns, in a ring from the head to the tail, so
+	 * that moving only ever touches the segments at both ends. Cell 0 is the head. */
+	struct snake_segment segments[MAX_SNAKE_LEN];
+	size_t               segments_start, segments_count;
+	SDL_Point            prev;
 
 	size_t   len;
 	size_t   requested_grow;
-	enum dir dir, next_dir;
+	enum dir dir;
 	float    offset;
 
+	struct turn turns[SNAKE_TURNS_CAPACITY];
+	size_t      turns_start, turns_count;
+
+	/* Timestamp of the key press behind the turn taken on the last move, 0 if it went straight */
+	Uint32 turned_at;
+
 	struct timer      tongue_timer;
 	enum tongue_state tongue_state;
 
-	struct snake_textures textures;
 	int r, g, b;
 
 	bool dead;
 };
 
-void snake_init(struct snake *s, SDL_Point start,
-                struct snake_textures textures, int r, int g, int b);
-void snake_update(struct snake *s);
+/* What one step of the gameplay did to the snake, for the caller to react to */
+struct snake_step {
+	SDL_Point from;
+	bool      moved, ate, died;
+
+	/* Where the snake bit itself and got cut off, bit_at is 0 if it did not */
+	size_t    bit_at;
+	SDL_Point bite;
+};
+
+void snake_init(struct snake *s, SDL_Point start, int r, int g, int b,
+                struct timer_wheel *clock, int tongue_event);
+void snake_update_tongue(struct snake *s, struct timer_wheel *clock);
+void snake_set_body(struct snake *s, const SDL_Point *cells, size_t len);
+SDL_Point snake_head(struct snake *s);
+SDL_Point snake_tail(struct snake *s);
+size_t    snake_find(struct snake *s, SDL_Point at, size_t from);
+void      snake_cells(struct snake *s, SDL_Point *cells);
+bool      snake_valid(struct snake *s);
 bool snake_move(struct snake *s, float by);
+bool snake_will_move(struct snake *s, float by);
+void snake_step(struct snake *s, float by, bool on_cheese, struct snake_step *step);
 void snake_grow(struct snake *s);
 void snake_shrink_to(struct snake *s, size_t len);
-void snake_change_dir(struct snake *s, enum dir dir);
-void snake_render(struct snake *s, SDL_Renderer *ren);
+bool     snake_change_dir(struct snake *s, enum dir dir, Uint32 timestamp);
+enum dir snake_next_dir(struct snake *s);
+void snake_render(struct snake *s, struct snake_textures *textures, struct render_queue *q,
+                  size_t now);
 
 #endif
@@ -0,0 +1,369 @@
+#include "softrast.h"
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#	define SOFTRAST_SSE2
+#endif
+
+/* The AVX2 kernels are compiled for the target on their own and only picked if the CPU has it */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	include <immintrin.h>
+#	define SOFTRAST_AVX2
+#endif
+
+/* Exact x / 255 rounded to nearest, for any x up to 255 * 255 */
+static inline uint32_t div255(uint32_t x) {
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+/* out = src * a + dst * (1 - a) for the colour, out = a + dst * (1 - a) for the alpha, which is
+ * what SDL_BLENDMODE_BLEND does */
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src) {
+	uint32_t a  = src >> 24;
+	uint32_t ia = 255 - a;
+
+	uint32_t r  = div255(((src >> 16) & 0xff) * a + ((dst >> 16) & 0xff) * ia);
+	uint32_t g  = div255(((src >> 8)  & 0xff) * a + ((dst >> 8)  & 0xff) * ia);
+	uint32_t b  = div255((src         & 0xff) * a + (dst         & 0xff) * ia);
+	uint32_t da = div255(255 * a + (dst >> 24) * ia);
+
+	return da << 24 | r << 16 | g << 8 | b;
+}
+
+static void blend_span_scalar(uint32_t *dst, const uint32_t *src, int n) {
+	for (int i = 0; i < n; ++ i)
+		dst[i] = blend_pixel(dst[i], src[i]);
+}
+
+static void fill_span_scalar(uint32_t *dst, uint32_t color, int n) {
+	if (color >> 24 == SDL_ALPHA_OPAQUE) {
+		for (int i = 0; i < n; ++ i)
+			dst[i] = color;
+	} else {
+		for (int i = 0; i < n; ++ i)
+			dst[i] = blend_pixel(dst[i], color);
+	}
+}
+
+/* The vector kernels work on pixels widened to 16 bits per channel, four channels per pixel. The
+ * alpha lane of the source is forced to 255 before multiplying, so that the same a * s + ia * d
+ * gives the blended alpha too. This relies on the alpha being the last byte in memory, which holds
+ * for SDL_PIXELFORMAT_ARGB8888 on the little endian CPUs these kernels are compiled for. */
+#ifdef SOFTRAST_SSE2
+static inline __m128i blend_half_sse2(__m128i s, __m128i d) {
+	const __m128i c255  = _mm_set1_epi16(255);
+	const __m128i c128  = _mm_set1_epi16(128);
+	const __m128i alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+	__m128i a  = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+	__m128i ia = _mm_sub_epi16(c255, a);
+
+	s = _mm_or_si128(s, alpha);
+
+	__m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, ia));
+	x = _mm_add_epi16(x, c128);
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static void blend_span_sse2(uint32_t *dst, const uint32_t *src, int n) {
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32(0xff000000);
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i s  = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i sa = _mm_and_si128(s, amask);
+
+		/* Sprites are mostly either fully transparent or fully opaque */
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xffff)
+			continue;
+		else if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, amask)) == 0xffff) {
+			_mm_storeu_si128((__m128i*)(dst + i), s);
+			continue;
+		}
+
+		__m128i d  = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i lo = blend_half_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+		__m128i hi = blend_half_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	blend_span_scalar(dst + i, src + i, n - i);
+}
+
+static void fill_span_sse2(uint32_t *dst, uint32_t color, int n) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c    = _mm_set1_epi32(color);
+
+	int i = 0;
+	if (color >> 24 == SDL_ALPHA_OPAQUE) {
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_si128((__m128i*)(dst + i), c);
+	} else {
+		__m128i s = _mm_unpacklo_epi8(c, zero);
+
+		for (; i + 4 <= n; i += 4) {
+			__m128i d  = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i lo = blend_half_sse2(s, _mm_unpacklo_epi8(d, zero));
+			__m128i hi = blend_half_sse2(s, _mm_unpackhi_epi8(d, zero));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+	}
+
+	fill_span_scalar(dst + i, color, n - i);
+}
+#endif
+
+#ifdef SOFTRAST_AVX2
+__attribute__((target("avx2")))
+static inline __m256i blend_half_avx2(__m256i s, __m256i d) {
+	const __m256i c255  = _mm256_set1_epi16(255);
+	const __m256i c128  = _mm256_set1_epi16(128);
+	const __m256i alpha = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+
+	__m256i a  = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+	__m256i ia = _mm256_sub_epi16(c255, a);
+
+	s = _mm256_or_si256(s, alpha);
+
+	__m256i x = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, ia));
+	x = _mm256_add_epi16(x, c128);
+	return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+/* Unpacking and packing both work inside of 128 bit lanes, so the pixels come back out in order */
+__attribute__((target("avx2")))
+static void blend_span_avx2(uint32_t *dst, const uint32_t *src, int n) {
+	const __m256i zero  = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32(0xff000000);
+
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i s  = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i sa = _mm256_and_si256(s, amask);
+
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) == -1)
+			continue;
+		else if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, amask)) == -1) {
+			_mm256_storeu_si256((__m256i*)(dst + i), s);
+			continue;
+		}
+
+		__m256i d  = _mm256_loadu_si256((const __m256i*)(dst + i));
+		__m256i lo = blend_half_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+		__m256i hi = blend_half_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+	}
+
+	blend_span_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void fill_span_avx2(uint32_t *dst, uint32_t color, int n) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c    = _mm256_set1_epi32(color);
+
+	int i = 0;
+	if (color >> 24 == SDL_ALPHA_OPAQUE) {
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_si256((__m256i*)(dst + i), c);
+	} else {
+		__m256i s = _mm256_unpacklo_epi8(c, zero);
+
+		for (; i + 8 <= n; i += 8) {
+			__m256i d  = _mm256_loadu_si256((const __m256i*)(dst + i));
+			__m256i lo = blend_half_avx2(s, _mm256_unpacklo_epi8(d, zero));
+			__m256i hi = blend_half_avx2(s, _mm256_unpackhi_epi8(d, zero));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+		}
+	}
+
+	fill_span_scalar(dst + i, color, n - i);
+}
+#endif
+
+void softrast_init(struct softrast *sr, int w, int h, softrast_lookup lookup, void *lookup_data) {
+	memset(sr, 0, sizeof(*sr));
+
+	sr->w           = w;
+	sr->h           = h;
+	sr->lookup      = lookup;
+	sr->lookup_data = lookup_data;
+
+	sr->pixels = (uint32_t*)calloc(w * h, sizeof(*sr->pixels));
+	sr->row    = (uint32_t*)malloc(w * sizeof(*sr->row));
+	if (sr->pixels == NULL || sr->row == NULL)
+		UNREACHABLE("malloc() fail");
+
+	const char *kernels = "scalar";
+	sr->blend_span = blend_span_scalar;
+	sr->fill_span  = fill_span_scalar;
+
+#ifdef SOFTRAST_SSE2
+	kernels        = "SSE2";
+	sr->blend_span = blend_span_sse2;
+	sr->fill_span  = fill_span_sse2;
+#endif
+
+#ifdef SOFTRAST_AVX2
+	if (SDL_HasAVX2()) {
+		kernels        = "AVX2";
+		sr->blend_span = blend_span_avx2;
+		sr->fill_span  = fill_span_avx2;
+	}
+#endif
+
+	SDL_Log("Software rasteriser uses %s kernels", kernels);
+}
+
+void softrast_free(struct softrast *sr) {
+	free(sr->pixels);
+	free(sr->row);
+}
+
+static bool softrast_clip(struct softrast *sr, SDL_Rect *r) {
+	SDL_Rect bounds = {
+		.x = 0,
+		.y = 0,
+		.w = sr->w,
+		.h = sr->h,
+	};
+
+	return SDL_IntersectRect(r, &bounds, r);
+}
+
+static void softrast_fill(struct softrast *sr, struct render_cmd *cmd) {
+	SDL_Rect r = cmd->dest;
+	if (cmd->color.a == SDL_ALPHA_TRANSPARENT || !softrast_clip(sr, &r))
+		return;
+
+	uint32_t color = (uint32_t)cmd->color.a << 24 | (uint32_t)cmd->color.r << 16 |
+	                 (uint32_t)cmd->color.g << 8  | (uint32_t)cmd->color.b;
+
+	for (int y = r.y; y < r.y + r.h; ++ y)
+		sr->fill_span(sr->pixels + y * sr->w + r.x, color, r.w);
+}
+
+/* Unscaled and unrotated copies blend straight from the surface rows */
+static void softrast_copy_direct(struct softrast *sr, SDL_Surface *s, SDL_Rect *src,
+                                 SDL_Rect *dest) {
+	SDL_Rect r = *dest;
+	if (!softrast_clip(sr, &r))
+		return;
+
+	int sx = src->x + r.x - dest->x;
+	int sy = src->y + r.y - dest->y;
+
+	for (int y = 0; y < r.h; ++ y) {
+		const uint32_t *row = (const uint32_t*)((const Uint8*)s->pixels + (sy + y) * s->pitch) + sx;
+		sr->blend_span(sr->pixels + (r.y + y) * sr->w + r.x, row, r.w);
+	}
+}
+
+/* Everything else is sampled by the nearest texel into the scratch row first. The destination
+ * pixel centres are rotated back around the centre of the destination rect, the same way
+ * SDL_RenderCopyEx rotates clockwise around it. */
+static void softrast_copy_sampled(struct softrast *sr, SDL_Surface *s, SDL_Rect *src,
+                                  SDL_Rect *dest, double angle, int alpha) {
+	double c, sn;
+	double turns = fmod(angle, 360);
+	if (turns < 0)
+		turns += 360;
+
+	/* Right angles are exact, so the snake face does not pick up rounding seams */
+	if (turns == 0 || turns == 90 || turns == 180 || turns == 270) {
+		static const double cos_table[] = {1, 0, -1, 0};
+		static const double sin_table[] = {0, 1, 0, -1};
+
+		c  = cos_table[(int)turns / 90];
+		sn = sin_table[(int)turns / 90];
+	} else {
+		c  = cos(turns * (M_PI / 180));
+		sn = sin(turns * (M_PI / 180));
+	}
+
+	double cx = dest->x + dest->w / 2.0;
+	double cy = dest->y + dest->h / 2.0;
+	double ex = fabs(dest->w / 2.0 * c) + fabs(dest->h / 2.0 * sn);
+	double ey = fabs(dest->w / 2.0 * sn) + fabs(dest->h / 2.0 * c);
+
+	SDL_Rect r = {
+		.x = floor(cx - ex),
+		.y = floor(cy - ey),
+		.w = ceil(cx + ex) - floor(cx - ex),
+		.h = ceil(cy + ey) - floor(cy - ey),
+	};
+	if (!softrast_clip(sr, &r))
+		return;
+
+	double scale_x = (double)src->w / dest->w;
+	double scale_y = (double)src->h / dest->h;
+
+	for (int y = r.y; y < r.y + r.h; ++ y) {
+		double v = y + 0.5 - cy;
+
+		for (int x = r.x; x < r.x + r.w; ++ x) {
+			double u = x + 0.5 - cx;
+
+			double du = u * c + v * sn + dest->w / 2.0;
+			double dv = v * c - u * sn + dest->h / 2.0;
+
+			uint32_t px = 0;
+			if (du >= 0 && du < dest->w && dv >= 0 && dv < dest->h) {
+				int tx = src->x + (int)(du * scale_x);
+				int ty = src->y + (int)(dv * scale_y);
+
+				px = ((const uint32_t*)((const Uint8*)s->pixels + ty * s->pitch))[tx];
+				if (alpha != SDL_ALPHA_OPAQUE)
+					px = (px & 0xffffff) | div255((px >> 24) * alpha) << 24;
+			}
+
+			sr->row[x - r.x] = px;
+		}
+
+		sr->blend_span(sr->pixels + y * sr->w + r.x, sr->row, r.w);
+	}
+}
+
+static void softrast_copy(struct softrast *sr, struct render_cmd *cmd) {
+	SDL_Surface *s = sr->lookup(sr->lookup_data, cmd->texture);
+	if (s == NULL || cmd->color.a == SDL_ALPHA_TRANSPARENT)
+		return;
+
+	SDL_Rect bounds = {
+		.x = 0,
+		.y = 0,
+		.w = s->w,
+		.h = s->h,
+	};
+
+	SDL_Rect src = bounds;
+	if (cmd->has_src && !SDL_IntersectRect(&cmd->src, &bounds, &src))
+		return;
+
+	if (cmd->dest.w <= 0 || cmd->dest.h <= 0)
+		return;
+
+	SDL_LockSurface(s);
+	if (cmd->angle == 0 && cmd->color.a == SDL_ALPHA_OPAQUE &&
+	    src.w == cmd->dest.w && src.h == cmd->dest.h)
+		softrast_copy_direct(sr, s, &src, &cmd->dest);
+	else
+		softrast_copy_sampled(sr, s, &src, &cmd->dest, cmd->angle, cmd->color.a);
+	SDL_UnlockSurface(s);
+}
+
+void softrast_draw(struct softrast *sr, struct render_cmd *cmds, size_t count) {
+	for (size_t i = 0; i < count; ++ i) {
+		if (cmds[i].type == RENDER_CMD_FILL)
+			softrast_fill(sr, &cmds[i]);
+		else
+			softrast_copy(sr, &cmds[i]);
+	}
+}
+
+void softrast_upload(struct softrast *sr, SDL_Texture *texture) {
+	if (SDL_UpdateTexture(texture, NULL, sr->pixels, sr->w * sizeof(*sr->pixels)) != 0)
+		SDL_Log("%s", SDL_GetError());
+}
@@ -0,0 +1,43 @@
+#ifndef SOFTRAST_H_HEADER_GUARD
+#define SOFTRAST_H_HEADER_GUARD
+
+#include <stdlib.h>  /* malloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* memset, memcpy */
+#include <math.h>    /* cos, sin, fmod, fabs, floor, ceil */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "render_queue.h"
+
+typedef SDL_Surface *(*softrast_lookup)(void *data, SDL_Texture *texture);
+typedef void (*softrast_blend_span)(uint32_t *dst, const uint32_t *src, int n);
+typedef void (*softrast_fill_span)(uint32_t *dst, uint32_t color, int n);
+
+/* Rasterises render queue commands on the CPU into an SDL_PIXELFORMAT_ARGB8888 buffer, which is
+ * then uploaded into a streaming texture once per frame. This replaces many small blended draws
+ * into a target texture, which SDL's own software renderer is slow at. Textures are drawn from
+ * the surfaces that the lookup maps them to, commands with textures it does not know are skipped. */
+struct softrast {
+	uint32_t *pixels;
+	int       w, h;
+
+	/* Scratch row for copies that have to be sampled before they can be blended */
+	uint32_t *row;
+
+	softrast_lookup lookup;
+	void           *lookup_data;
+
+	softrast_blend_span blend_span;
+	softrast_fill_span  fill_span;
+};
+
+void softrast_init(struct softrast *sr, int w, int h, softrast_lookup lookup, void *lookup_data);
+void softrast_free(struct softrast *sr);
+
+void softrast_draw(struct softrast *sr, struct render_cmd *cmds, size_t count);
+void softrast_upload(struct softrast *sr, SDL_Texture *texture);
+
+#endif
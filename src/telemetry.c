@@ -0,0 +1,202 @@
+#include "telemetry.h"
+
+#ifdef __linux__
+
+/* Either all of the data makes it into the log or none of it, a write that stops halfway is cut
+ * back off, so that the log never ends in a partial record */
+static void telemetry_write(struct telemetry *t, const void *data, size_t size) {
+	const char *at   = (const char*)data;
+	size_t      left = size;
+	while (left > 0) {
+		ssize_t written = write(t->fd, at, left);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+
+			SDL_Log("Could not write the telemetry: %s", strerror(errno));
+			if (ftruncate(t->fd, t->size) < 0)
+				SDL_Log("Could not cut the partial write off the telemetry: %s", strerror(errno));
+			return;
+		}
+
+		at   += written;
+		left -= written;
+	}
+
+	t->size += size;
+}
+
+/* Moves everything logged so far into the batch, so it can go out in a single write */
+static size_t telemetry_drain(struct telemetry *t) {
+	size_t count = 0;
+	for (int i = 0; i < TELEMETRY_PRODUCERS; ++ i) {
+		struct telemetry_ring *r = &t->rings[i];
+
+		unsigned tail = SDL_AtomicGet(&r->tail);
+		unsigned head = SDL_AtomicGet(&r->head);
+		for (; tail != head; ++ tail)
+			t->batch[count ++] = r->records[tail % TELEMETRY_RING_CAPACITY];
+
+		SDL_AtomicSet(&r->tail, tail);
+	}
+
+	return count;
+}
+
+static int telemetry_work(void *data) {
+	struct telemetry *t = (struct telemetry*)data;
+
+	bool stopping = false;
+	while (!stopping) {
+		stopping = SDL_SemWaitTimeout(t->stop, TELEMETRY_FLUSH_MS) == 0;
+
+		size_t count = telemetry_drain(t);
+		if (count > 0)
+			telemetry_write(t, t->batch, count * sizeof(*t->batch));
+
+		Uint64 now = SDL_GetTicks();
+		if (stopping || now - t->last_sync >= TELEMETRY_FSYNC_MS) {
+			fsync(t->fd);
+			t->last_sync = now;
+		}
+	}
+
+	return 0;
+}
+
+/* Appends to the log at the path, which has to be empty or written by the same version. A
+ * partial record left at the end by a crash is cut off first. */
+void telemetry_init(struct telemetry *t, const char *path) {
+	memset(t, 0, sizeof(*t));
+
+	t->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (t->fd < 0) {
+		SDL_Log("Could not open '%s' for the telemetry: %s", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	struct stat st;
+	if (fstat(t->fd, &st) < 0) {
+		SDL_Log("Could not stat '%s': %s", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	struct telemetry_header header = {
+		.version     = TELEMETRY_VERSION,
+		.record_size = sizeof(struct telemetry_record),
+		.tick_rate   = TICK_RATE,
+	};
+	memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+
+	struct telemetry_header existing;
+	ssize_t size = pread(t->fd, &existing, sizeof(existing), 0);
+	if (size == 0)
+		telemetry_write(t, &header, sizeof(header));
+	else if (size != sizeof(existing) || memcmp(&existing, &header, sizeof(header)) != 0) {
+		SDL_Log("'%s' is not a telemetry log of this version", path);
+		exit(EXIT_FAILURE);
+	} else {
+		uint64_t records = ((uint64_t)st.st_size - sizeof(header)) / sizeof(struct telemetry_record);
+		t->size = sizeof(header) + records * sizeof(struct telemetry_record);
+
+		if ((uint64_t)st.st_size != t->size) {
+			SDL_Log("Cutting a partial record off the end of '%s'", path);
+			if (ftruncate(t->fd, t->size) < 0) {
+				SDL_Log("Could not truncate '%s': %s", path, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	t->rings = (struct telemetry_ring*)calloc(TELEMETRY_PRODUCERS, sizeof(*t->rings));
+	t->batch = (struct telemetry_record*)malloc(sizeof(*t->batch) *
+	                                            TELEMETRY_PRODUCERS * TELEMETRY_RING_CAPACITY);
+	if (t->rings == NULL || t->batch == NULL)
+		UNREACHABLE("malloc() fail");
+
+	t->stop      = SDL_CreateSemaphore(0);
+	t->last_sync = SDL_GetTicks();
+	if (t->stop == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	t->writer = SDL_CreateThread(telemetry_work, "telemetry", t);
+	if (t->writer == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Log("Logging telemetry to '%s'", path);
+}
+
+/* Everything that logs has to be stopped by now */
+void telemetry_free(struct telemetry *t) {
+	SDL_SemPost(t->stop);
+	SDL_WaitThread(t->writer, NULL);
+
+	int dropped = 0;
+	for (int i = 0; i < TELEMETRY_PRODUCERS; ++ i)
+		dropped += SDL_AtomicGet(&t->rings[i].dropped);
+
+	if (dropped > 0)
+		SDL_Log("Dropped %i telemetry records that did not fit", dropped);
+
+	close(t->fd);
+	SDL_DestroySemaphore(t->stop);
+	free(t->batch);
+	free(t->rings);
+}
+
+void telemetry_log(struct telemetry *t, int producer, struct telemetry_record *record) {
+	struct telemetry_ring *r = &t->rings[producer];
+
+	unsigned head = SDL_AtomicGet(&r->head);
+	if (head - (unsigned)SDL_AtomicGet(&r->tail) >= TELEMETRY_RING_CAPACITY) {
+		SDL_AtomicIncRef(&r->dropped);
+		return;
+	}
+
+	r->records[head % TELEMETRY_RING_CAPACITY] = *record;
+	SDL_AtomicSet(&r->head, head + 1);
+}
+
+#else
+
+/* The log is written with POSIX calls, which are only used on Linux, same as the server */
+void telemetry_init(struct telemetry *t, const char *path) {
+	UNUSED(t);
+	SDL_Log("Cannot log telemetry to '%s', the telemetry only runs on Linux", path);
+	exit(EXIT_FAILURE);
+}
+
+void telemetry_free(struct telemetry *t) {
+	UNUSED(t);
+}
+
+void telemetry_log(struct telemetry *t, int producer, struct telemetry_record *record) {
+	UNUSED(t);
+	UNUSED(producer);
+	UNUSED(record);
+}
+
+#endif
+
+/* Returns true once the window is full, with its summary written into the record */
+bool frame_times_add(struct frame_times *f, uint32_t us, struct telemetry_record *summary) {
+	f->us[f->count ++] = us;
+	if (f->count < TELEMETRY_FRAMES_WINDOW)
+		return false;
+
+	qsort(f->us, f->count, sizeof(*f->us), compare_u32);
+
+	memset(summary, 0, sizeof(*summary));
+	summary->kind      = TELEMETRY_FRAMES;
+	summary->values[0] = f->count;
+	summary->values[1] = f->us[f->count / 2];
+	summary->values[2] = f->us[f->count * 99 / 100];
+	summary->values[3] = f->us[f->count - 1];
+
+	f->count = 0;
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef TELEMETRY_H_HEADER_GUARD
+#define TELEMETRY_H_HEADER_GUARD
+
+#include <stdlib.h>  /* malloc, free, qsort */
+#include <stdbool.h> /* bool, true, false */
+#include <string.h>  /* memset, memcpy, memcmp, strerror */
+#include <stdint.h>  /* uint64_t */
+
+#ifdef __linux__
+#	include <errno.h>     /* errno, EINTR */
+#	include <fcntl.h>     /* open, O_RDWR, O_CREAT, O_APPEND */
+#	include <unistd.h>    /* write, pread, fsync, ftruncate, close */
+#	include <sys/stat.h>  /* fstat, stat */
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "config.h"
+#include "telemetry_record.h"
+
+#define TELEMETRY_RING_CAPACITY 1024
+#define TELEMETRY_FLUSH_MS      250
+#define TELEMETRY_FSYNC_MS      5000
+
+/* Every thread that logs gets a ring of its own */
+enum {
+	TELEMETRY_SIM = 0,
+	TELEMETRY_RENDER,
+
+	TELEMETRY_PRODUCERS,
+};
+
+/* Single producer, single consumer. Records that do not fit are dropped and counted, logging must
+ * never hold up the thread it happens on. */
+struct telemetry_ring {
+	struct telemetry_record records[TELEMETRY_RING_CAPACITY];
+	SDL_atomic_t            head, tail;
+	SDL_atomic_t            dropped;
+};
+
+struct telemetry {
+	int      fd;
+	uint64_t size; /* Up to the end of the last whole record, anything past it gets cut off */
+
+	struct telemetry_ring   *rings;
+	struct telemetry_record *batch;
+
+	SDL_Thread *writer;
+	SDL_sem    *stop;
+	Uint64      last_sync;
+};
+
+void telemetry_init(struct telemetry *t, const char *path);
+void telemetry_free(struct telemetry *t);
+void telemetry_log(struct telemetry *t, int producer, struct telemetry_record *record);
+
+/* Collects frame times and logs a summary of them every TELEMETRY_FRAMES_WINDOW frames */
+#define TELEMETRY_FRAMES_WINDOW TICK_RATE
+
+struct frame_times {
+	uint32_t us[TELEMETRY_FRAMES_WINDOW];
+	size_t   count;
+};
+
+bool frame_times_add(struct frame_times *f, uint32_t us, struct telemetry_record *summary);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_RECORD_H_HEADER_GUARD
+#define TELEMETRY_RECORD_H_HEADER_GUARD
+
+#include <stdint.h> /* uint16_t, uint32_t, uint64_t */
+#include <assert.h> /* static_assert */
+
+/* The layout of the telemetry log, shared with the tools that read it, so it must not depend on
+ * SDL or anything else of the game. The log is a header followed by fixed size records, and only
+ * ever gets appended to. */
+
+#define TELEMETRY_MAGIC   "CNKT"
+#define TELEMETRY_VERSION 1
+
+struct telemetry_header {
+	char     magic[4];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t tick_rate;
+};
+
+enum telemetry_kind {
+	TELEMETRY_GAME_START = 0,
+	TELEMETRY_SAMPLE,      /* values: length, score */
+	TELEMETRY_CHEESE,      /* values: length, score */
+	TELEMETRY_BITE,        /* values: length left, score */
+	TELEMETRY_DEATH,       /* values: length, score */
+	TELEMETRY_FRAMES,      /* values: frames, median, 99th percentile and worst frame time in us */
+
+	TELEMETRY_KINDS_COUNT,
+};
+
+struct telemetry_record {
+	uint16_t kind;
+	uint16_t reserved;
+	uint32_t game;
+	uint64_t tick;
+	uint32_t values[4];
+};
+
+static_assert(sizeof(struct telemetry_record) == 32, "Telemetry records have to stay 32 bytes");
+
+#endif
@@ -1,28 +1,226 @@
 #include "timer.h"
 
-void timer_init(struct timer *t, size_t time) {
+void timer_wheel_init(struct timer_wheel *w) {
+	memset(w, 0, sizeof(*w));
+
+	for (size_t i = 0; i < TIMER_WHEEL_LEVELS; ++ i) {
+		for (size_t j = 0; j < TIMER_WHEEL_SLOTS; ++ j)
+			w->slots[i][j] = TIMER_WHEEL_NONE;
+	}
+
+	for (size_t i = 0; i < TIMER_WHEEL_ENTRIES; ++ i)
+		w->entries[i].next = i + 1 < TIMER_WHEEL_ENTRIES? i + 1 : TIMER_WHEEL_NONE;
+
+	w->free_head = 0;
+}
+
+/* Picks the lowest level whose ring still spans the distance to the expiry */
+static void timer_wheel_link(struct timer_wheel *w, uint16_t i) {
+	struct timer_entry *e = &w->entries[i];
+
+	size_t delta = e->at - w->now;
+	size_t level = 0;
+	while (level + 1 < TIMER_WHEEL_LEVELS &&
+	       delta >= (size_t)1 << (TIMER_WHEEL_BITS * (level + 1)))
+		++ level;
+
+	e->level = level;
+	e->slot  = (e->at >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+	e->prev  = TIMER_WHEEL_NONE;
+	e->next  = w->slots[e->level][e->slot];
+
+	if (e->next != TIMER_WHEEL_NONE)
+		w->entries[e->next].prev = i;
+
+	w->slots[e->level][e->slot] = i;
+}
+
+static void timer_wheel_unlink(struct timer_wheel *w, uint16_t i) {
+	struct timer_entry *e = &w->entries[i];
+
+	if (e->prev != TIMER_WHEEL_NONE)
+		w->entries[e->prev].next = e->next;
+	else
+		w->slots[e->level][e->slot] = e->next;
+
+	if (e->next != TIMER_WHEEL_NONE)
+		w->entries[e->next].prev = e->prev;
+}
+
+uint16_t timer_wheel_schedule(struct timer_wheel *w, size_t at, int event) {
+	if (w->free_head == TIMER_WHEEL_NONE)
+		UNREACHABLE("Timer wheel is full");
+
+	/* The slot of the current tick was already processed */
+	if (at <= w->now)
+		at = w->now + 1;
+	else if (at - w->now >= TIMER_WHEEL_RANGE)
+		at = w->now + TIMER_WHEEL_RANGE - 1;
+
+	uint16_t i = w->free_head;
+	w->free_head = w->entries[i].next;
+
+	w->entries[i].at    = at;
+	w->entries[i].event = event;
+	timer_wheel_link(w, i);
+
+	return i;
+}
+
+void timer_wheel_cancel(struct timer_wheel *w, uint16_t entry) {
+	timer_wheel_unlink(w, entry);
+
+	w->entries[entry].next = w->free_head;
+	w->free_head           = entry;
+}
+
+/* Moves every entry of a higher level slot down to where it belongs now */
+static void timer_wheel_cascade(struct timer_wheel *w, size_t level) {
+	size_t   slot = (w->now >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+	uint16_t i    = w->slots[level][slot];
+
+	w->slots[level][slot] = TIMER_WHEEL_NONE;
+	while (i != TIMER_WHEEL_NONE) {
+		uint16_t next = w->entries[i].next;
+		timer_wheel_link(w, i);
+		i = next;
+	}
+}
+
+void timer_wheel_advance(struct timer_wheel *w) {
+	++ w->now;
+
+	w->fired_start = 0;
+	w->fired_count = 0;
+
+	for (size_t level = 1; level < TIMER_WHEEL_LEVELS; ++ level) {
+		if ((w->now & (((size_t)1 << (TIMER_WHEEL_BITS * level)) - 1)) != 0)
+			break;
+
+		timer_wheel_cascade(w, level);
+	}
+
+	/* Everything in the lowest level is less than a full ring away, so the whole slot is due */
+	size_t   slot = w->now & (TIMER_WHEEL_SLOTS - 1);
+	uint16_t i    = w->slots[0][slot];
+
+	w->slots[0][slot] = TIMER_WHEEL_NONE;
+	while (i != TIMER_WHEEL_NONE) {
+		struct timer_entry *e    = &w->entries[i];
+		uint16_t            next = e->next;
+
+		assert(e->at == w->now);
+		w->fired[w->fired_count ++] = e->event;
+
+		e->next      = w->free_head;
+		w->free_head = i;
+
+		i = next;
+	}
+}
+
+bool timer_wheel_poll(struct timer_wheel *w, int *event) {
+	if (w->fired_start >= w->fired_count)
+		return false;
+
+	*event = w->fired[w->fired_start ++];
+	return true;
+}
+
+/* For a wheel that comes from outside, like a save. Every entry has to be either free or linked
+ * exactly once into the slot it is due in, which is what advancing the wheel relies on. */
+bool timer_wheel_valid(struct timer_wheel *w) {
+	bool seen[TIMER_WHEEL_ENTRIES] = {0};
+
+	for (uint16_t i = w->free_head; i != TIMER_WHEEL_NONE; i = w->entries[i].next) {
+		if (i >= TIMER_WHEEL_ENTRIES || seen[i])
+			return false;
+
+		seen[i] = true;
+	}
+
+	for (size_t level = 0; level < TIMER_WHEEL_LEVELS; ++ level) {
+		size_t shift = TIMER_WHEEL_BITS * level;
+
+		for (size_t slot = 0; slot < TIMER_WHEEL_SLOTS; ++ slot) {
+			uint16_t prev = TIMER_WHEEL_NONE;
+			for (uint16_t i = w->slots[level][slot]; i != TIMER_WHEEL_NONE; i = w->entries[i].next) {
+				if (i >= TIMER_WHEEL_ENTRIES || seen[i])
+					return false;
+
+				struct timer_entry *e = &w->entries[i];
+				if (e->prev != prev || e->level != level || e->slot != slot)
+					return false;
+
+				/* Due after now, within the span of its level, and in a slot the wheel still gets
+				 * to before then */
+				if (e->at <= w->now || e->at - w->now >= (size_t)1 << (shift + TIMER_WHEEL_BITS))
+					return false;
+
+				if (((e->at >> shift) & (TIMER_WHEEL_SLOTS - 1)) != slot)
+					return false;
+
+				if (level > 0 && e->at >> shift == w->now >> shift)
+					return false;
+
+				seen[i] = true;
+				prev    = i;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < TIMER_WHEEL_ENTRIES; ++ i) {
+		if (!seen[i])
+			return false;
+	}
+
+	return w->fired_start <= w->fired_count && w->fired_count <= TIMER_WHEEL_ENTRIES;
+}
+
+void timer_init(struct timer *t, size_t time, int event) {
 	memset(t, 0, sizeof(*t));
 
+	t->time  = time;
+	t->event = event;
+}
+
+void timer_set(struct timer *t, size_t time) {
 	t->time = time;
 }
 
-void timer_start(struct timer *t) {
-	t->now        = t->time;
-	t->just_ended = false;
+void timer_start(struct timer *t, struct timer_wheel *w) {
+	/* The entry of a timer that is still running has not fired yet, so it is still its own */
+	if (timer_active(t, w->now))
+		timer_wheel_cancel(w, t->entry);
+
+	t->start = w->now;
+	t->entry = timer_wheel_schedule(w, w->now + t->time, t->event);
+	t->end   = w->entries[t->entry].at;
 }
 
-void timer_update(struct timer *t) {
-	if (t->now > 0) {
-		-- t->now;
-		if (t->now <= 0)
-			t->just_ended = true;
-	} else {
-		if (t->just_ended)
-			t->just_ended = false;
-	}
+float timer_unit(struct timer *t, size_t now, bool reverse) {
+	float left = timer_active(t, now)? t->end - now : 0;
+	float time = t->end - t->start;
+
+	if (time <= 0)
+		return reverse? 1 : 0;
+
+	return (reverse? time - left : left) / time;
 }
 
-float timer_unit(struct timer *t, bool reverse) {
-	float tmp = reverse? t->time - t->now : t->now;
-	return tmp / t->time;
+/* A running timer has to own an entry of the wheel that is still scheduled, since starting the
+ * timer again cancels it. Needs a valid wheel. */
+bool timer_valid(struct timer *t, struct timer_wheel *w) {
+	if (!timer_active(t, w->now))
+		return true;
+
+	if (t->entry >= TIMER_WHEEL_ENTRIES)
+		return false;
+
+	for (uint16_t i = w->free_head; i != TIMER_WHEEL_NONE; i = w->entries[i].next) {
+		if (i == t->entry)
+			return false;
+	}
+
+	return w->entries[t->entry].at == t->end && w->entries[t->entry].event == t->event;
 }
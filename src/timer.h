@@ -4,23 +4,64 @@
 #include <stdlib.h>  /* size_t */
 #include <string.h>  /* memset */
 #include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint8_t, uint16_t */
 
-struct timer {
-	size_t now, time;
-	bool   just_ended;
+#include "common.h"
+
+#define TIMER_WHEEL_BITS    6
+#define TIMER_WHEEL_SLOTS   (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS  3
+#define TIMER_WHEEL_ENTRIES 16
+#define TIMER_WHEEL_NONE    0xffff
+
+/* The furthest ahead an expiry can be scheduled, anything later is clamped to it */
+#define TIMER_WHEEL_RANGE ((size_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+struct timer_entry {
+	size_t   at;
+	int      event;
+	uint16_t next, prev;
+	uint8_t  level, slot;
 };
 
-void  timer_init(struct timer *t, size_t time);
-void  timer_start(struct timer *t);
-void  timer_update(struct timer *t);
-float timer_unit(struct timer *t, bool reverse);
+/* A clock that only does work for the timers that expire on a tick. Every level has a ring of
+ * slots, each one TIMER_WHEEL_SLOTS times as wide as a slot of the level below, and entries that
+ * are due later sit in the higher levels until they get close enough to be moved down. Expired
+ * entries turn into events that the owner polls after advancing the clock. Entries link to each
+ * other by index, so the wheel can be copied around as plain memory. */
+struct timer_wheel {
+	size_t now;
 
-inline bool timer_active(struct timer *t) {
-	return t->now > 0;
-}
+	uint16_t           slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	struct timer_entry entries[TIMER_WHEEL_ENTRIES];
+	uint16_t           free_head;
+
+	int    fired[TIMER_WHEEL_ENTRIES];
+	size_t fired_start, fired_count;
+};
+
+void     timer_wheel_init(struct timer_wheel *w);
+uint16_t timer_wheel_schedule(struct timer_wheel *w, size_t at, int event);
+void     timer_wheel_cancel(struct timer_wheel *w, uint16_t entry);
+void     timer_wheel_advance(struct timer_wheel *w);
+bool     timer_wheel_poll(struct timer_wheel *w, int *event);
+bool     timer_wheel_valid(struct timer_wheel *w);
+
+/* A span of ticks on a clock, which fires its event into the clock when it ends */
+struct timer {
+	size_t   time, start, end;
+	int      event;
+	uint16_t entry;
+};
+
+void  timer_init(struct timer *t, size_t time, int event);
+void  timer_set(struct timer *t, size_t time);
+void  timer_start(struct timer *t, struct timer_wheel *w);
+float timer_unit(struct timer *t, size_t now, bool reverse);
+bool  timer_valid(struct timer *t, struct timer_wheel *w);
 
-inline bool timer_just_ended(struct timer *t) {
-	return t->just_ended;
+inline bool timer_active(struct timer *t, size_t now) {
+	return now < t->end;
 }
 
 #endif
@@ -0,0 +1,186 @@
+#include "trace.h"
+
+SDL_atomic_t trace_enabled;
+
+extern inline Uint64 trace_begin(void);
+extern inline void   trace_end(const char *name, Uint64 start);
+
+static FILE       *trace_file;
+static SDL_Thread *trace_flusher;
+static SDL_sem    *trace_stop;
+static Uint64      trace_origin, trace_freq;
+static bool        trace_first;
+
+static void        *trace_rings[TRACE_MAX_THREADS];
+static SDL_atomic_t trace_rings_count;
+
+static _Thread_local struct trace_ring *trace_local;
+static _Thread_local bool               trace_unregistered;
+
+static struct trace_ring *trace_register(const char *name) {
+	int tid = SDL_AtomicAdd(&trace_rings_count, 1);
+	if (tid >= TRACE_MAX_THREADS) {
+		SDL_Log("Too many threads to trace, not tracing '%s'", name);
+		trace_unregistered = true;
+		return NULL;
+	}
+
+	struct trace_ring *r = (struct trace_ring*)calloc(1, sizeof(*r));
+	if (r == NULL)
+		UNREACHABLE("calloc() fail");
+
+	r->thread = name;
+	r->tid    = tid;
+
+	/* Only published to the flusher once it is filled in */
+	SDL_AtomicSetPtr(&trace_rings[tid], r);
+	return r;
+}
+
+/* Threads that never name themselves still get traced, just without a name */
+void trace_thread(const char *name) {
+	if (SDL_AtomicGet(&trace_enabled) && trace_local == NULL && !trace_unregistered)
+		trace_local = trace_register(name);
+}
+
+void trace_record(const char *name, Uint64 start) {
+	Uint64 end = SDL_GetPerformanceCounter();
+
+	if (trace_local == NULL) {
+		if (trace_unregistered)
+			return;
+
+		trace_local = trace_register("thread");
+		if (trace_local == NULL)
+			return;
+	}
+
+	struct trace_ring *r = trace_local;
+
+	unsigned head = SDL_AtomicGet(&r->head);
+	if (head - (unsigned)SDL_AtomicGet(&r->tail) >= TRACE_RING_CAPACITY) {
+		SDL_AtomicIncRef(&r->dropped);
+		return;
+	}
+
+	struct trace_event *e = &r->events[head & (TRACE_RING_CAPACITY - 1)];
+	e->name  = name;
+	e->start = start;
+	e->end   = end;
+
+	SDL_AtomicSet(&r->head, head + 1);
+}
+
+static double trace_us(Uint64 counter) {
+	return (double)(counter - trace_origin) * 1000000 / trace_freq;
+}
+
+static void trace_separate(void) {
+	if (!trace_first)
+		fputs(",\n", trace_file);
+
+	trace_first = false;
+}
+
+static void trace_flush(void) {
+	int count = SDL_AtomicGet(&trace_rings_count);
+	if (count > TRACE_MAX_THREADS)
+		count = TRACE_MAX_THREADS;
+
+	for (int i = 0; i < count; ++ i) {
+		struct trace_ring *r = (struct trace_ring*)SDL_AtomicGetPtr(&trace_rings[i]);
+		if (r == NULL)
+			continue;
+
+		if (!r->named) {
+			trace_separate();
+			fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,"
+			        "\"args\":{\"name\":\"%s\"}}", r->tid, r->thread);
+
+			r->named = true;
+		}
+
+		unsigned tail = SDL_AtomicGet(&r->tail);
+		unsigned head = SDL_AtomicGet(&r->head);
+		for (; tail != head; ++ tail) {
+			struct trace_event *e = &r->events[tail & (TRACE_RING_CAPACITY - 1)];
+
+			trace_separate();
+			fprintf(trace_file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,"
+			        "\"ts\":%.3f,\"dur\":%.3f}", e->name, r->tid, trace_us(e->start),
+			        (double)(e->end - e->start) * 1000000 / trace_freq);
+		}
+
+		SDL_AtomicSet(&r->tail, tail);
+	}
+}
+
+static int trace_flush_work(void *data) {
+	UNUSED(data);
+
+	while (SDL_SemWaitTimeout(trace_stop, TRACE_FLUSH_MS) != 0)
+		trace_flush();
+
+	trace_flush();
+	return 0;
+}
+
+/* Writes a Chrome trace event file, which Perfetto and chrome://tracing can open */
+void trace_init(const char *path) {
+	trace_file = fopen(path, "w");
+	if (trace_file == NULL) {
+		SDL_Log("Could not open '%s' for the trace", path);
+		exit(EXIT_FAILURE);
+	}
+
+	fputs("[\n", trace_file);
+
+	trace_origin = SDL_GetPerformanceCounter();
+	trace_freq   = SDL_GetPerformanceFrequency();
+	trace_first  = true;
+
+	trace_stop = SDL_CreateSemaphore(0);
+	if (trace_stop == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_AtomicSet(&trace_enabled, true);
+
+	trace_flusher = SDL_CreateThread(trace_flush_work, "trace", NULL);
+	if (trace_flusher == NULL) {
+		SDL_Log("%s", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Log("Tracing to '%s'", path);
+}
+
+/* Every other traced thread has to be stopped by now */
+void trace_finish(void) {
+	if (!SDL_AtomicGet(&trace_enabled))
+		return;
+
+	SDL_SemPost(trace_stop);
+	SDL_WaitThread(trace_flusher, NULL);
+
+	SDL_AtomicSet(&trace_enabled, false);
+
+	fputs("\n]\n", trace_file);
+	fclose(trace_file);
+	SDL_DestroySemaphore(trace_stop);
+
+	int dropped = 0;
+	for (int i = 0; i < TRACE_MAX_THREADS; ++ i) {
+		struct trace_ring *r = (struct trace_ring*)trace_rings[i];
+		if (r == NULL)
+			continue;
+
+		dropped += SDL_AtomicGet(&r->dropped);
+		free(r);
+		trace_rings[i] = NULL;
+	}
+
+	if (dropped > 0)
+		SDL_Log("Dropped %i trace events that did not fit", dropped);
+}
@@ -0,0 +1,61 @@
+#ifndef TRACE_H_HEADER_GUARD
+#define TRACE_H_HEADER_GUARD
+
+#include <stdio.h>   /* FILE, fopen, fclose, fprintf */
+#include <stdlib.h>  /* calloc, free */
+#include <stdbool.h> /* bool, true, false */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+#include "config.h"
+
+/* The main thread, the simulation, the two that initialise audio and fonts, and the job workers */
+#define TRACE_FIXED_THREADS 4
+#define TRACE_MAX_THREADS   (TRACE_FIXED_THREADS + JOBS_MAX_WORKERS)
+#define TRACE_RING_CAPACITY 4096
+#define TRACE_FLUSH_MS      100
+
+static_assert((TRACE_RING_CAPACITY & (TRACE_RING_CAPACITY - 1)) == 0,
+              "TRACE_RING_CAPACITY has to be a power of two");
+
+struct trace_event {
+	const char *name;
+	Uint64      start, end;
+};
+
+/* Only the thread it belongs to pushes into a ring, and only the flusher pops from it, so the two
+ * indices are all the synchronisation it needs. Events that do not fit are dropped and counted. */
+struct trace_ring {
+	const char *thread;
+	int         tid;
+	bool        named;
+
+	struct trace_event events[TRACE_RING_CAPACITY];
+	SDL_atomic_t       head, tail;
+	SDL_atomic_t       dropped;
+};
+
+/* Only set while a trace is being written, checked before doing anything else. Read by every
+ * thread, so it is atomic. */
+extern SDL_atomic_t trace_enabled;
+
+void trace_init(const char *path);
+void trace_finish(void);
+void trace_thread(const char *name);
+void trace_record(const char *name, Uint64 start);
+
+/* A scope is the span between the two, recorded as a single complete event:
+ *     Uint64 start = trace_begin();
+ *     ...
+ *     trace_end("name", start); */
+inline Uint64 trace_begin(void) {
+	return SDL_AtomicGet(&trace_enabled)? SDL_GetPerformanceCounter() : 0;
+}
+
+inline void trace_end(const char *name, Uint64 start) {
+	if (SDL_AtomicGet(&trace_enabled))
+		trace_record(name, start);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "triple_buffer.h"
+
+/* Set in the middle index when it holds a value the consumer has not seen yet */
+#define TRIPLE_BUFFER_FRESH 4
+
+void triple_buffer_init(struct triple_buffer *t, size_t size) {
+	for (size_t i = 0; i < 3; ++ i) {
+		t->get[i] = calloc(1, size);
+		if (t->get[i] == NULL)
+			UNREACHABLE("calloc() fail");
+	}
+
+	t->write = 0;
+	t->read  = 1;
+	SDL_AtomicSet(&t->middle, 2);
+}
+
+void triple_buffer_free(struct triple_buffer *t) {
+	for (size_t i = 0; i < 3; ++ i)
+		free(t->get[i]);
+}
+
+void *triple_buffer_write(struct triple_buffer *t) {
+	return t->get[t->write];
+}
+
+void triple_buffer_publish(struct triple_buffer *t) {
+	t->write = SDL_AtomicSet(&t->middle, t->write | TRIPLE_BUFFER_FRESH) & 3;
+}
+
+void *triple_buffer_read(struct triple_buffer *t, bool *fresh) {
+	*fresh = SDL_AtomicGet(&t->middle) & TRIPLE_BUFFER_FRESH;
+	if (*fresh)
+		t->read = SDL_AtomicSet(&t->middle, t->read) & 3;
+
+	return t->get[t->read];
+}
@@ -0,0 +1,27 @@
+#ifndef TRIPLE_BUFFER_H_HEADER_GUARD
+#define TRIPLE_BUFFER_H_HEADER_GUARD
+
+#include <stdlib.h>  /* size_t, malloc, free */
+#include <stdbool.h> /* bool, true, false */
+
+#include <SDL2/SDL.h>
+
+#include "common.h"
+
+/* Lock-free hand-off of the latest value from one producer thread to one consumer thread. The
+ * producer always has a buffer of its own to write into, the consumer always has a buffer of its
+ * own to read from, and the third one sits in the middle holding the latest published value. */
+struct triple_buffer {
+	void        *get[3];
+	SDL_atomic_t middle;
+	int          write, read;
+};
+
+void triple_buffer_init(struct triple_buffer *t, size_t size);
+void triple_buffer_free(struct triple_buffer *t);
+
+void *triple_buffer_write(struct triple_buffer *t);
+void  triple_buffer_publish(struct triple_buffer *t);
+void *triple_buffer_read(struct triple_buffer *t, bool *fresh);
+
+#endif
@@ -0,0 +1,196 @@
+#include <stdio.h>   /* printf, fprintf, fopen, fclose */
+#include <stdlib.h>  /* exit, EXIT_FAILURE, EXIT_SUCCESS, malloc, free, qsort */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* strlen, strrchr, strcmp */
+#include <ctype.h>   /* toupper, isalnum */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+/* Packs images into a single atlas and writes a header with the rect of every image in it:
+ *     atlas_packer ATLAS.png RECTS.h IMAGE.png...
+ *
+ * Every image gets its edge pixels repeated once around it, so that linear filtering at the edge
+ * of a rect never picks up the image next to it. The rects in the header exclude that border. */
+
+#define BORDER    1
+#define MAX_WIDTH 4096
+
+struct sprite {
+	const char  *path;
+	SDL_Surface *s;
+	int          x, y;
+};
+
+static void error(const char *msg) {
+	fprintf(stderr, "Error: %s\n", msg);
+	exit(EXIT_FAILURE);
+}
+
+/* Tallest first, so that every shelf wastes as little height as it can */
+static int sprite_compare(const void *a_, const void *b_) {
+	const struct sprite *a = (const struct sprite*)a_;
+	const struct sprite *b = (const struct sprite*)b_;
+
+	if (a->s->h != b->s->h)
+		return b->s->h - a->s->h;
+	else if (a->s->w != b->s->w)
+		return b->s->w - a->s->w;
+
+	return strcmp(a->path, b->path);
+}
+
+static int next_pow2(int x) {
+	int pow2 = 1;
+	while (pow2 < x)
+		pow2 *= 2;
+
+	return pow2;
+}
+
+/* Places the sprites on shelves of the given width, returns the height used */
+static int pack(struct sprite *sprites, int count, int width) {
+	int x = 0, y = 0, shelf = 0;
+	for (int i = 0; i < count; ++ i) {
+		int w = sprites[i].s->w + BORDER * 2;
+		int h = sprites[i].s->h + BORDER * 2;
+
+		if (x + w > width) {
+			x      = 0;
+			y     += shelf;
+			shelf  = 0;
+		}
+
+		sprites[i].x = x + BORDER;
+		sprites[i].y = y + BORDER;
+
+		x += w;
+		if (h > shelf)
+			shelf = h;
+	}
+
+	return y + shelf;
+}
+
+static void blit_extruded(SDL_Surface *atlas, struct sprite *sprite) {
+	SDL_Surface *s   = sprite->s;
+	uint32_t    *src = (uint32_t*)s->pixels;
+	uint32_t    *dst = (uint32_t*)atlas->pixels;
+	int          src_stride = s->pitch / 4, dst_stride = atlas->pitch / 4;
+
+	for (int y = -BORDER; y < s->h + BORDER; ++ y) {
+		int sy = y < 0? 0 : y >= s->h? s->h - 1 : y;
+
+		for (int x = -BORDER; x < s->w + BORDER; ++ x) {
+			int sx = x < 0? 0 : x >= s->w? s->w - 1 : x;
+
+			dst[(sprite->y + y) * dst_stride + sprite->x + x] = src[sy * src_stride + sx];
+		}
+	}
+}
+
+static void write_name(FILE *f, const char *path) {
+	const char *name = strrchr(path, '/');
+	name = name == NULL? path : name + 1;
+
+	const char *ext = strrchr(name, '.');
+	size_t      len = ext == NULL? strlen(name) : (size_t)(ext - name);
+
+	for (size_t i = 0; i < len; ++ i)
+		fputc(isalnum((unsigned char)name[i])? toupper((unsigned char)name[i]) : '_', f);
+}
+
+static void write_rects(const char *path, struct sprite *sprites, int count, int w, int h) {
+	FILE *f = fopen(path, "w");
+	if (f == NULL)
+		error("Could not open the rects header for writing");
+
+	fprintf(f, "/* Generated by tools/atlas_packer.c, do not edit */\n\n");
+	fprintf(f, "#ifndef ATLAS_RECTS_H_HEADER_GUARD\n#define ATLAS_RECTS_H_HEADER_GUARD\n\n");
+	fprintf(f, "#define ATLAS_W %i\n#define ATLAS_H %i\n\n", w, h);
+
+	for (int i = 0; i < count; ++ i) {
+		fprintf(f, "#define ATLAS_RECT_");
+		write_name(f, sprites[i].path);
+		fprintf(f, " {%i, %i, %i, %i}\n", sprites[i].x, sprites[i].y,
+		        sprites[i].s->w, sprites[i].s->h);
+	}
+
+	fprintf(f, "\n#endif\n");
+	if (fclose(f) != 0)
+		error("Could not write the rects header");
+}
+
+int main(int argc, char **argv) {
+	if (argc < 4) {
+		fprintf(stderr, "Usage: %s ATLAS.png RECTS.h IMAGE.png...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (IMG_Init(IMG_INIT_PNG) == 0)
+		error(IMG_GetError());
+
+	int            count   = argc - 3;
+	struct sprite *sprites = (struct sprite*)malloc(sizeof(*sprites) * count);
+	if (sprites == NULL)
+		error("Out of memory");
+
+	int widest = 0;
+	for (int i = 0; i < count; ++ i) {
+		SDL_Surface *s = IMG_Load(argv[i + 3]);
+		if (s == NULL)
+			error(IMG_GetError());
+
+		sprites[i].path = argv[i + 3];
+		sprites[i].s    = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_RGBA32, 0);
+		if (sprites[i].s == NULL)
+			error(SDL_GetError());
+
+		SDL_FreeSurface(s);
+
+		if (sprites[i].s->w + BORDER * 2 > widest)
+			widest = sprites[i].s->w + BORDER * 2;
+	}
+
+	qsort(sprites, count, sizeof(*sprites), sprite_compare);
+
+	/* Tries every power of two width that fits the widest image, and keeps the smallest atlas */
+	int best_w = 0, best_h = 0;
+	for (int w = next_pow2(widest); w <= MAX_WIDTH; w *= 2) {
+		int h = next_pow2(pack(sprites, count, w));
+		if (best_w == 0 || w * h < best_w * best_h || (w * h == best_w * best_h && h < best_h)) {
+			best_w = w;
+			best_h = h;
+		}
+	}
+
+	if (best_w == 0)
+		error("The images do not fit into an atlas");
+
+	pack(sprites, count, best_w);
+
+	SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, best_w, best_h, 32,
+	                                                    SDL_PIXELFORMAT_RGBA32);
+	if (atlas == NULL)
+		error(SDL_GetError());
+
+	memset(atlas->pixels, 0, atlas->pitch * atlas->h);
+	for (int i = 0; i < count; ++ i)
+		blit_extruded(atlas, &sprites[i]);
+
+	if (IMG_SavePNG(atlas, argv[1]) != 0)
+		error(IMG_GetError());
+
+	write_rects(argv[2], sprites, count, best_w, best_h);
+	printf("Packed %i images into a %ix%i atlas\n", count, best_w, best_h);
+
+	for (int i = 0; i < count; ++ i)
+		SDL_FreeSurface(sprites[i].s);
+
+	SDL_FreeSurface(atlas);
+	free(sprites);
+
+	IMG_Quit();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCH_H_HEADER_GUARD
+#define BENCH_H_HEADER_GUARD
+
+#include <stdlib.h> /* malloc, free */
+
+#include "game.h"
+
+/* Shared by the benchmarks, which link with every object of the game but main.o and drive its
+ * main loop themselves */
+
+/* Hands the game the same arguments, with the ones the benchmark needs added on. The returned
+ * array has to stay around for as long as the game runs, and then be freed. */
+static char **bench_args(int argc_, char **argv_, const char **extra, int extra_count) {
+	char **bench_argv = (char**)malloc(sizeof(*bench_argv) * (argc_ + extra_count + 1));
+	if (bench_argv == NULL)
+		UNREACHABLE("malloc() fail");
+
+	int bench_argc = 0;
+	for (int i = 0; i < argc_; ++ i)
+		bench_argv[bench_argc ++] = argv_[i];
+
+	for (int i = 0; i < extra_count; ++ i)
+		bench_argv[bench_argc ++] = (char*)extra[i];
+
+	bench_argv[bench_argc] = NULL;
+	args(bench_argc, bench_argv);
+	return bench_argv;
+}
+
+/* Renders until the view moved on by a tick, false if the game quit before it did */
+static bool bench_frame(struct game *g) {
+	size_t tick = g->view != NULL? g->view->tick : 0;
+
+	while (game_running(g)) {
+		game_handle_events(g);
+		game_render(g);
+
+		if (g->view != NULL && g->view->tick != tick)
+			return true;
+	}
+
+	return false;
+}
+
+#endif
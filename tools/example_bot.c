@@ -0,0 +1,103 @@
+/* A greedy bot, as an example of the bot API. It heads for the closest cheese, and never turns into
+ * a wall or its own body if it can help it.
+ *
+ * Build: cc -shared -fPIC -Isrc -o example_bot.so tools/example_bot.c
+ * Run:   ./app --bot ./example_bot.so
+ */
+
+#include <stdlib.h> /* abs, malloc, free */
+#include <stdint.h> /* int32_t, uint32_t */
+
+#include "bot_api.h"
+
+struct example_bot {
+	uint32_t cols, rows;
+};
+
+static struct cnake_bot_point next_cell(struct cnake_bot_point at, int dir) {
+	switch (dir) {
+	case CNAKE_BOT_UP:    -- at.y; break;
+	case CNAKE_BOT_LEFT:  -- at.x; break;
+	case CNAKE_BOT_DOWN:  ++ at.y; break;
+	case CNAKE_BOT_RIGHT: ++ at.x; break;
+	}
+
+	return at;
+}
+
+/* The tail moves out of the way, so it does not count */
+static int is_free(const struct cnake_bot_view *v, struct cnake_bot_point at) {
+	if (at.x < 0 || at.y < 0 || at.x >= (int32_t)v->cols || at.y >= (int32_t)v->rows)
+		return 0;
+
+	for (uint32_t i = 1; i + 1 < v->len; ++ i) {
+		if (v->body[i].x == at.x && v->body[i].y == at.y)
+			return 0;
+	}
+
+	return 1;
+}
+
+static int32_t closest_cheese(const struct cnake_bot_view *v, struct cnake_bot_point at) {
+	int32_t closest = INT32_MAX;
+	for (uint32_t i = 0; i < v->cheese_count; ++ i) {
+		int32_t dist = abs(v->cheese[i].x - at.x) + abs(v->cheese[i].y - at.y);
+		if (dist < closest)
+			closest = dist;
+	}
+
+	return closest;
+}
+
+static void *example_bot_create(uint32_t cols, uint32_t rows) {
+	struct example_bot *bot = (struct example_bot*)malloc(sizeof(*bot));
+	if (bot != NULL) {
+		bot->cols = cols;
+		bot->rows = rows;
+	}
+
+	return bot;
+}
+
+static int example_bot_think(void *data, const struct cnake_bot_view *v) {
+	(void)data;
+
+	int     best      = v->next_dir;
+	int32_t best_dist = INT32_MAX;
+	int     best_free = 0;
+
+	for (int dir = CNAKE_BOT_UP; dir <= CNAKE_BOT_RIGHT; ++ dir) {
+		/* Turning back is not a move */
+		if ((dir - (int)v->next_dir) % 2 == 0 && dir != (int)v->next_dir)
+			continue;
+
+		struct cnake_bot_point at = next_cell(v->body[0], dir);
+
+		int     free = is_free(v, at);
+		int32_t dist = closest_cheese(v, at);
+		if (free > best_free || (free == best_free && dist < best_dist)) {
+			best      = dir;
+			best_dist = dist;
+			best_free = free;
+		}
+	}
+
+	return best;
+}
+
+static void example_bot_destroy(void *data) {
+	free(data);
+}
+
+static const struct cnake_bot example_bot = {
+	.api_version = CNAKE_BOT_API_VERSION,
+	.name        = "example",
+
+	.create  = example_bot_create,
+	.think   = example_bot_think,
+	.destroy = example_bot_destroy,
+};
+
+const struct cnake_bot *cnake_bot_entry(void) {
+	return &example_bot;
+}
@@ -0,0 +1,122 @@
+/* Lets the Hamiltonian cycle AI play one game until the snake fills the whole map, headless and in
+ * lockstep so that every tick gets rendered. At every tenth of the map filled, reports how many ticks
+ * and how much time it took to get there, and how long the parts of a tick took along the way.
+ *
+ * Build: make bin/fill_bench
+ * Run:   ./bin/fill_bench --speed 5
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtoul, free, EXIT_SUCCESS, EXIT_FAILURE */
+
+#include "bench.h"
+
+#define FILL_MILESTONES 10
+#define FILL_MAX_TICKS  2000000
+
+struct phase {
+	uint64_t total;
+	uint32_t worst;
+	size_t   count;
+};
+
+enum {
+	PHASE_UPDATE = 0,
+	PHASE_THINK,
+	PHASE_SPAWN,
+	PHASE_RENDER,
+
+	PHASES_COUNT,
+};
+
+static const char *phase_names[PHASES_COUNT] = {
+	[PHASE_UPDATE] = "update",
+	[PHASE_THINK]  = "think",
+	[PHASE_SPAWN]  = "spawn",
+	[PHASE_RENDER] = "render",
+};
+
+static void phase_add(struct phase *p, uint32_t us) {
+	p->total += us;
+	p->count += 1;
+	if (us > p->worst)
+		p->worst = us;
+}
+
+static double seconds_since(Uint64 start) {
+	return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+static void bench_report(size_t len, size_t ticks, double seconds, struct phase *phases) {
+	printf("%3zu%% %4zu cells %8zu ticks %8.2f s", len * 100 / HAMILTON_CELLS, len, ticks, seconds);
+	for (size_t i = 0; i < PHASES_COUNT; ++ i) {
+		struct phase *p = &phases[i];
+		printf("  %s %.1f/%u us", phase_names[i], p->count > 0? (double)p->total / p->count : 0,
+		       p->worst);
+	}
+
+	printf("\n");
+	memset(phases, 0, sizeof(*phases) * PHASES_COUNT);
+}
+
+int main(int argc_, char **argv_) {
+	const char *extra[]    = {"--headless", "--lockstep", "--hamilton"};
+	char      **bench_argv = bench_args(argc_, argv_, extra, SDL_arraysize(extra));
+
+	const char *max_ticks_arg = arg_value("--max-ticks");
+	size_t      max_ticks     = max_ticks_arg != NULL? strtoul(max_ticks_arg, NULL, 10) :
+	                            FILL_MAX_TICKS;
+
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+	struct game g = {0};
+	game_init(&g);
+
+	while (!SDL_AtomicGet(&g.fonts_ready))
+		SDL_Delay(1);
+
+	struct phase phases[PHASES_COUNT] = {0};
+	size_t       milestone = 1, ticks = 0, len = 0;
+	bool         filled    = false, died = false;
+	Uint64       start     = SDL_GetPerformanceCounter();
+
+	while (ticks < max_ticks && bench_frame(&g)) {
+		++ ticks;
+		len = g.view->snake.len;
+
+		phase_add(&phases[PHASE_UPDATE], g.view->update_us);
+		phase_add(&phases[PHASE_THINK],  g.view->think_us);
+		phase_add(&phases[PHASE_RENDER], g.render_us);
+		if (g.view->tick % CHEESE_SPAWN_TICK_DELAY == 0)
+			phase_add(&phases[PHASE_SPAWN], g.view->spawn_us);
+
+		if (g.view->state == STATE_DEAD) {
+			died = true;
+			break;
+		}
+
+		if (len * FILL_MILESTONES >= milestone * HAMILTON_CELLS) {
+			bench_report(len, ticks, seconds_since(start), phases);
+			while (len * FILL_MILESTONES >= milestone * HAMILTON_CELLS)
+				++ milestone;
+		}
+
+		if (len >= HAMILTON_CELLS) {
+			filled = true;
+			break;
+		}
+	}
+
+	double seconds = seconds_since(start);
+	game_finish(&g);
+	free(bench_argv);
+
+	if (died)
+		printf("Died at %zu cells after %zu ticks\n", len, ticks);
+	else if (!filled)
+		printf("Stopped at %zu cells after %zu ticks\n", len, ticks);
+	else
+		printf("Filled all %i cells in %zu ticks, %.2f s\n", HAMILTON_CELLS, ticks, seconds);
+
+	return filled? EXIT_SUCCESS : EXIT_FAILURE;
+}
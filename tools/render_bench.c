@@ -0,0 +1,182 @@
+/* Renders the frames of a scenario through SDL's software renderer on the dummy video driver, and
+ * reports how long they took along with how many of the renderer's calls each one made. The game
+ * runs in lockstep, so every frame shows the next tick and the same scenario always renders the
+ * same frames. The calls are counted by linking with -Wl,--wrap for each of them.
+ *
+ * Build: make bin/render_bench
+ * Run:   ./bin/render_bench --scenario res/scenarios/full_board.txt --frames 300
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* strtoul, qsort, malloc, free, EXIT_SUCCESS */
+
+#include "bench.h"
+
+#define BENCH_FRAMES 300
+#define BENCH_WARMUP 10
+
+enum {
+	CALL_RENDER_COPY = 0,
+	CALL_RENDER_COPY_EX,
+	CALL_RENDER_FILL_RECT,
+	CALL_RENDER_FILL_RECTS,
+	CALL_SET_RENDER_DRAW_COLOR,
+	CALL_SET_RENDER_DRAW_BLEND_MODE,
+	CALL_SET_TEXTURE_COLOR_MOD,
+	CALL_SET_TEXTURE_ALPHA_MOD,
+	CALL_SET_TEXTURE_BLEND_MODE,
+	CALL_SET_RENDER_TARGET,
+	CALL_UPDATE_TEXTURE,
+
+	CALLS_COUNT,
+};
+
+static const char *call_names[CALLS_COUNT] = {
+	[CALL_RENDER_COPY]                = "SDL_RenderCopy",
+	[CALL_RENDER_COPY_EX]             = "SDL_RenderCopyEx",
+	[CALL_RENDER_FILL_RECT]           = "SDL_RenderFillRect",
+	[CALL_RENDER_FILL_RECTS]          = "SDL_RenderFillRects",
+	[CALL_SET_RENDER_DRAW_COLOR]      = "SDL_SetRenderDrawColor",
+	[CALL_SET_RENDER_DRAW_BLEND_MODE] = "SDL_SetRenderDrawBlendMode",
+	[CALL_SET_TEXTURE_COLOR_MOD]      = "SDL_SetTextureColorMod",
+	[CALL_SET_TEXTURE_ALPHA_MOD]      = "SDL_SetTextureAlphaMod",
+	[CALL_SET_TEXTURE_BLEND_MODE]     = "SDL_SetTextureBlendMode",
+	[CALL_SET_RENDER_TARGET]          = "SDL_SetRenderTarget",
+	[CALL_UPDATE_TEXTURE]             = "SDL_UpdateTexture",
+};
+
+/* Only the render thread calls any of these */
+static size_t calls[CALLS_COUNT];
+
+int __real_SDL_RenderCopy(SDL_Renderer *ren, SDL_Texture *texture, const SDL_Rect *src,
+                          const SDL_Rect *dest);
+int __real_SDL_RenderCopyEx(SDL_Renderer *ren, SDL_Texture *texture, const SDL_Rect *src,
+                            const SDL_Rect *dest, double angle, const SDL_Point *center,
+                            SDL_RendererFlip flip);
+int __real_SDL_RenderFillRect(SDL_Renderer *ren, const SDL_Rect *rect);
+int __real_SDL_RenderFillRects(SDL_Renderer *ren, const SDL_Rect *rects, int count);
+int __real_SDL_SetRenderDrawColor(SDL_Renderer *ren, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+int __real_SDL_SetRenderDrawBlendMode(SDL_Renderer *ren, SDL_BlendMode blend);
+int __real_SDL_SetTextureColorMod(SDL_Texture *texture, Uint8 r, Uint8 g, Uint8 b);
+int __real_SDL_SetTextureAlphaMod(SDL_Texture *texture, Uint8 a);
+int __real_SDL_SetTextureBlendMode(SDL_Texture *texture, SDL_BlendMode blend);
+int __real_SDL_SetRenderTarget(SDL_Renderer *ren, SDL_Texture *texture);
+int __real_SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels,
+                             int pitch);
+
+int __wrap_SDL_RenderCopy(SDL_Renderer *ren, SDL_Texture *texture, const SDL_Rect *src,
+                          const SDL_Rect *dest) {
+	++ calls[CALL_RENDER_COPY];
+	return __real_SDL_RenderCopy(ren, texture, src, dest);
+}
+
+int __wrap_SDL_RenderCopyEx(SDL_Renderer *ren, SDL_Texture *texture, const SDL_Rect *src,
+                            const SDL_Rect *dest, double angle, const SDL_Point *center,
+                            SDL_RendererFlip flip) {
+	++ calls[CALL_RENDER_COPY_EX];
+	return __real_SDL_RenderCopyEx(ren, texture, src, dest, angle, center, flip);
+}
+
+int __wrap_SDL_RenderFillRect(SDL_Renderer *ren, const SDL_Rect *rect) {
+	++ calls[CALL_RENDER_FILL_RECT];
+	return __real_SDL_RenderFillRect(ren, rect);
+}
+
+int __wrap_SDL_RenderFillRects(SDL_Renderer *ren, const SDL_Rect *rects, int count) {
+	++ calls[CALL_RENDER_FILL_RECTS];
+	return __real_SDL_RenderFillRects(ren, rects, count);
+}
+
+int __wrap_SDL_SetRenderDrawColor(SDL_Renderer *ren, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	++ calls[CALL_SET_RENDER_DRAW_COLOR];
+	return __real_SDL_SetRenderDrawColor(ren, r, g, b, a);
+}
+
+int __wrap_SDL_SetRenderDrawBlendMode(SDL_Renderer *ren, SDL_BlendMode blend) {
+	++ calls[CALL_SET_RENDER_DRAW_BLEND_MODE];
+	return __real_SDL_SetRenderDrawBlendMode(ren, blend);
+}
+
+int __wrap_SDL_SetTextureColorMod(SDL_Texture *texture, Uint8 r, Uint8 g, Uint8 b) {
+	++ calls[CALL_SET_TEXTURE_COLOR_MOD];
+	return __real_SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+int __wrap_SDL_SetTextureAlphaMod(SDL_Texture *texture, Uint8 a) {
+	++ calls[CALL_SET_TEXTURE_ALPHA_MOD];
+	return __real_SDL_SetTextureAlphaMod(texture, a);
+}
+
+int __wrap_SDL_SetTextureBlendMode(SDL_Texture *texture, SDL_BlendMode blend) {
+	++ calls[CALL_SET_TEXTURE_BLEND_MODE];
+	return __real_SDL_SetTextureBlendMode(texture, blend);
+}
+
+int __wrap_SDL_SetRenderTarget(SDL_Renderer *ren, SDL_Texture *texture) {
+	++ calls[CALL_SET_RENDER_TARGET];
+	return __real_SDL_SetRenderTarget(ren, texture);
+}
+
+int __wrap_SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels,
+                             int pitch) {
+	++ calls[CALL_UPDATE_TEXTURE];
+	return __real_SDL_UpdateTexture(texture, rect, pixels, pitch);
+}
+
+int main(int argc_, char **argv_) {
+	const char *extra[]    = {"--headless", "--lockstep"};
+	char      **bench_argv = bench_args(argc_, argv_, extra, SDL_arraysize(extra));
+
+	const char *frames_arg = arg_value("--frames");
+	size_t      frames     = frames_arg != NULL? strtoul(frames_arg, NULL, 10) : BENCH_FRAMES;
+	const char *scenario   = arg_value("--scenario");
+
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+	struct game g = {0};
+	game_init(&g);
+
+	/* The score is only drawn once the font is in, which would make the first frames differ */
+	while (!SDL_AtomicGet(&g.fonts_ready))
+		SDL_Delay(1);
+
+	/* The first frames load the atlas and fill the caches */
+	for (size_t i = 0; i < BENCH_WARMUP; ++ i)
+		bench_frame(&g);
+
+	uint32_t *us = (uint32_t*)malloc(sizeof(*us) * (frames > 0? frames : 1));
+	if (us == NULL)
+		UNREACHABLE("malloc() fail");
+
+	memset(calls, 0, sizeof(calls));
+
+	struct render_stats stats = {0};
+	size_t              drawn = 0;
+	for (; drawn < frames && bench_frame(&g); ++ drawn) {
+		us[drawn] = g.render_us;
+
+		stats.cmds          += g.render_stats.cmds;
+		stats.draw_calls    += g.render_stats.draw_calls;
+		stats.state_changes += g.render_stats.state_changes;
+	}
+
+	game_finish(&g);
+
+	printf("%s, %zu frames\n", scenario != NULL? scenario : "new game", drawn);
+	if (drawn == 0)
+		return EXIT_SUCCESS;
+
+	qsort(us, drawn, sizeof(*us), compare_u32);
+	printf("  %-28s %u us median, %u us 99th percentile, %u us worst\n", "render time",
+	       us[drawn / 2], us[drawn * 99 / 100], us[drawn - 1]);
+	printf("  %-28s %.1f commands, %.1f draw calls, %.1f state changes\n", "render queue",
+	       (double)stats.cmds / drawn, (double)stats.draw_calls / drawn,
+	       (double)stats.state_changes / drawn);
+
+	for (size_t i = 0; i < CALLS_COUNT; ++ i)
+		printf("  %-28s %.1f per frame\n", call_names[i], (double)calls[i] / drawn);
+
+	free(us);
+	free(bench_argv);
+	return EXIT_SUCCESS;
+}
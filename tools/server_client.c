@@ -0,0 +1,97 @@
+/* Puts load on a server started with --server: opens a number of sessions, steers every one of
+ * them at random and counts the updates that come back.
+ *
+ * Build: cc -o server_client tools/server_client.c
+ * Run:   ./app --server /tmp/cnake.sock & ./server_client /tmp/cnake.sock 1000 10
+ */
+
+#include <stdio.h>        /* printf, fprintf, perror */
+#include <stdlib.h>       /* atoi, rand, srand, EXIT_SUCCESS, EXIT_FAILURE */
+#include <stdint.h>       /* uint8_t, uint64_t */
+#include <string.h>       /* strncpy */
+#include <time.h>         /* time, clock_gettime */
+#include <unistd.h>       /* close */
+#include <sys/socket.h>   /* socket, connect, recv, send */
+#include <sys/un.h>       /* sockaddr_un */
+#include <sys/epoll.h>    /* epoll_create1, epoll_ctl, epoll_wait */
+
+/* Commands and flags of the protocol in src/server.h */
+#define CMD_RESTART 4
+#define FLAG_DEAD   1
+
+#define EVENTS 256
+
+static double seconds(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		fprintf(stderr, "Usage: %s <socket> <sessions> <seconds>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int sessions = atoi(argv[2]);
+	int duration = atoi(argv[3]);
+	srand(time(NULL));
+
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+
+	int epoll_fd = epoll_create1(0);
+	if (epoll_fd < 0) {
+		perror("epoll_create1");
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < sessions; ++ i) {
+		int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+		if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+			perror("connect");
+			return EXIT_FAILURE;
+		}
+
+		struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+
+	uint64_t updates = 0, bytes = 0, deaths = 0, closed = 0;
+	double   start   = seconds();
+
+	struct epoll_event events[EVENTS];
+	while (seconds() - start < duration) {
+		int count = epoll_wait(epoll_fd, events, EVENTS, 100);
+		for (int i = 0; i < count; ++ i) {
+			int fd = events[i].data.fd;
+
+			uint8_t buf[4096];
+			ssize_t size = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+			if (size <= 0) {
+				if (size == 0) {
+					++ closed;
+					close(fd);
+				}
+				continue;
+			}
+
+			++ updates;
+			bytes += size;
+
+			uint8_t cmd = rand() % 4;
+			if (size > 6 && buf[6] & FLAG_DEAD) {
+				++ deaths;
+				cmd = CMD_RESTART;
+			}
+
+			send(fd, &cmd, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+		}
+	}
+
+	double elapsed = seconds() - start;
+	printf("%i sessions, %.0f updates/s, %.1f bytes per update, %llu deaths, %llu closed\n",
+	       sessions, updates / elapsed, updates > 0? (double)bytes / updates : 0,
+	       (unsigned long long)deaths, (unsigned long long)closed);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+#include <stdio.h>   /* printf, fprintf, fopen, fread, fclose */
+#include <stdlib.h>  /* exit, EXIT_FAILURE, EXIT_SUCCESS, realloc, free */
+#include <stdbool.h> /* bool, true, false */
+#include <stdint.h>  /* uint32_t, uint64_t */
+#include <string.h>  /* memcmp, memset */
+
+#include "telemetry_record.h"
+
+/* Summarises a telemetry log written by the game:
+ *     telemetry_reader FILE */
+
+struct game {
+	uint64_t start, end;
+	uint32_t start_len, max_len, min_len, score;
+	uint32_t cheese, bites;
+	uint64_t len_sum, samples;
+	bool     died;
+};
+
+struct frames {
+	uint64_t windows, frames;
+	uint64_t median_sum;
+	uint32_t worst_p99, worst;
+};
+
+static struct game *games       = NULL;
+static size_t       games_count = 0;
+
+static struct game *new_game(uint64_t tick, uint32_t len, uint32_t score) {
+	games = (struct game*)realloc(games, sizeof(*games) * (games_count + 1));
+	if (games == NULL) {
+		fprintf(stderr, "Error: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct game *g = &games[games_count ++];
+	memset(g, 0, sizeof(*g));
+
+	g->start     = tick;
+	g->end       = tick;
+	g->start_len = len;
+	g->max_len   = len;
+	g->min_len   = len;
+	g->score     = score;
+	return g;
+}
+
+static void game_record(struct game *g, struct telemetry_record *r) {
+	uint32_t len = r->values[0];
+
+	g->end   = r->tick;
+	g->score = r->values[1];
+	if (len > g->max_len)
+		g->max_len = len;
+	if (len < g->min_len)
+		g->min_len = len;
+
+	switch (r->kind) {
+	case TELEMETRY_SAMPLE:
+		g->len_sum += len;
+		++ g->samples;
+		break;
+
+	case TELEMETRY_CHEESE: ++ g->cheese;   break;
+	case TELEMETRY_BITE:   ++ g->bites;    break;
+	case TELEMETRY_DEATH:  g->died = true; break;
+
+	default: break;
+	}
+}
+
+static void frames_record(struct frames *f, struct telemetry_record *r) {
+	++ f->windows;
+	f->frames     += r->values[0];
+	f->median_sum += r->values[1];
+
+	if (r->values[2] > f->worst_p99)
+		f->worst_p99 = r->values[2];
+	if (r->values[3] > f->worst)
+		f->worst = r->values[3];
+}
+
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s FILE\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Error: Could not open '%s'\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	struct telemetry_header header;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, TELEMETRY_MAGIC, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "Error: '%s' is not a telemetry log\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	if (header.version != TELEMETRY_VERSION ||
+	    header.record_size != sizeof(struct telemetry_record)) {
+		fprintf(stderr, "Error: '%s' is version %u, expected %u\n", argv[1],
+		        header.version, TELEMETRY_VERSION);
+		return EXIT_FAILURE;
+	}
+
+	/* Records of a game always follow its start, anything before the first start is ignored */
+	struct frames           frames  = {0};
+	struct game            *current = NULL;
+	struct telemetry_record r;
+	size_t                  records = 0;
+	while (fread(&r, sizeof(r), 1, file) == 1) {
+		++ records;
+
+		if (r.kind == TELEMETRY_GAME_START)
+			current = new_game(r.tick, r.values[0], r.values[1]);
+		else if (r.kind == TELEMETRY_FRAMES)
+			frames_record(&frames, &r);
+		else if (current != NULL && r.kind < TELEMETRY_KINDS_COUNT)
+			game_record(current, &r);
+	}
+
+	fclose(file);
+
+	printf("%zu records, %zu games\n\n", records, games_count);
+	printf("%6s %10s %8s %6s %6s %8s %6s %6s %5s\n",
+	       "game", "seconds", "score", "cheese", "bites", "avg len", "min", "max", "died");
+
+	uint64_t deaths = 0, cheese = 0, score = 0;
+	for (size_t i = 0; i < games_count; ++ i) {
+		struct game *g = &games[i];
+
+		double seconds = (double)(g->end - g->start) / header.tick_rate;
+		double avg_len = g->samples > 0? (double)g->len_sum / g->samples : g->start_len;
+
+		printf("%6zu %10.1f %8u %6u %6u %8.1f %6u %6u %5s\n", i + 1, seconds, g->score,
+		       g->cheese, g->bites, avg_len, g->min_len, g->max_len, g->died? "yes" : "no");
+
+		deaths += g->died;
+		cheese += g->cheese;
+		score  += g->score;
+	}
+
+	if (games_count > 0)
+		printf("\n%llu deaths, %llu cheese eaten, %.1f average score\n",
+		       (unsigned long long)deaths, (unsigned long long)cheese,
+		       (double)score / games_count);
+
+	if (frames.windows > 0)
+		printf("%llu frames, %.2f ms average median, %.2f ms worst 99th percentile, "
+		       "%.2f ms worst\n", (unsigned long long)frames.frames,
+		       (double)frames.median_sum / frames.windows / 1000,
+		       (double)frames.worst_p99 / 1000, (double)frames.worst / 1000);
+
+	free(games);
+	return EXIT_SUCCESS;
+}